@@ -0,0 +1,39 @@
+#ifndef __ACCUMULATOR_H
+#define __ACCUMULATOR_H
+
+
+// Compensated (Kahan) sum in single precision: the rounding error stays within a few ulps of the
+// result whatever the number of terms, where a plain float sum drifts with each term. The ESP32-S3
+// has no double-precision FPU, so this is much cheaper than a double integrator.
+// It relies on strict IEEE float semantics: never build it with -ffast-math.
+struct KahanSum
+{
+    float sum;
+    float comp;             // Rounding error of sum, to be subtracted
+
+    void init() {sum = 0.f; comp = 0.f;}
+    void add(float val)
+    {
+        float y = val - comp;
+        float t = sum + y;
+        comp = (t - sum) - y;
+        sum = t;
+    }
+    void merge(const KahanSum &other) {add(other.sum); add(-other.comp);}
+    float get() const {return sum - comp;}
+};
+
+
+// Time-weighted mean of a per-period value: compensated integral of val.dt, divided by the
+// duration only when the mean is read (no division per period)
+struct TimeMean
+{
+    KahanSum integral;
+
+    void init() {integral.init();}
+    void add(float val, float dt) {integral.add(val * dt);}
+    void merge(const TimeMean &other) {integral.merge(other.integral);}
+    float get(float duration) const {return (duration > 0.f) ? integral.get() / duration : 0.f;}
+};
+
+#endif      // __ACCUMULATOR_H
@@ -2,6 +2,7 @@
 #define __ADC_H
 
 #define DEBUG false
+#define ADC_SIMULATION false        // Replace the ADC by synthetic frames (offline benchmarking of the DSP)
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -11,15 +12,25 @@
 
 #include "def.h"
 #include "chrono.h"
+#include "adcDemux.h"
+#include "spscRing.h"
 
-#define DMA_BUFFER_SIZE (1024 * SOC_ADC_DIGI_DATA_BYTES_PER_CONV)
+#define ADC_FRAME_SIZE  (ADC_BLOCK_SIZE * NB_CHANNELS * SOC_ADC_DIGI_DATA_BYTES_PER_CONV)
+#define DMA_BUFFER_SIZE (4 * ADC_FRAME_SIZE)
+#define ADC_RING_SIZE   8                  // Blocks buffered between the acquisition and the DSP task
 
 void adc_task(void *pvParameters);
+void dsp_task(void *pvParameters);
 
 extern SemaphoreHandle_t mutex;
-extern volatile int adcValues[NB_CHANNELS];
+extern TaskHandle_t dspTaskHandle;
 
-// Chrono object for timing measurements
+// Ring of demultiplexed blocks between the acquisition and the DSP task
+extern SpscRing<AdcBlock, ADC_RING_SIZE> adcRing;
+extern AdcDemux adcDemux;
+
+// Chrono objects for timing measurements
 extern Chrono adcChrono;
+extern Chrono dspChrono;
 
 #endif      // __ADC_H
@@ -0,0 +1,36 @@
+#ifndef __ADCDEMUX_H
+#define __ADCDEMUX_H
+
+#include <stdint.h>
+
+#include "def.h"
+
+#define ADC_BLOCK_SIZE      64                                  // Conversion sets per DMA frame
+#define ADC_BLOCK_PERIOD    (ADC_BLOCK_SIZE * TIM_PERIOD)       // µs
+#define ADC_HW_CHANNELS     16                                  // TYPE2 records carry a 4-bit channel index
+
+
+// Per-channel sample blocks demultiplexed from one DMA frame
+struct AdcBlock {
+    uint16_t nbSamples;
+    uint16_t samples[NB_CHANNELS][ADC_BLOCK_SIZE];
+};
+
+
+class AdcDemux
+{
+public:
+    AdcDemux(const uint8_t* adcChannels);
+    ~AdcDemux() {};
+    uint16_t parse(const uint8_t* frame, uint32_t size, AdcBlock &block);
+    uint32_t getNbInvalid() {return m_nbInvalid;}
+    uint32_t getNbDiscarded() {return m_nbDiscarded;}
+
+private:
+    int8_t m_channelMap[ADC_HW_CHANNELS];       // hardware channel -> logical channel (-1 if not sampled)
+    uint16_t m_count[NB_CHANNELS];
+    uint32_t m_nbInvalid;
+    uint32_t m_nbDiscarded;
+};
+
+#endif      // __ADCDEMUX_H
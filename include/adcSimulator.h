@@ -0,0 +1,35 @@
+#ifndef __ADCSIMULATOR_H
+#define __ADCSIMULATOR_H
+
+#include <stdint.h>
+
+#include "def.h"
+
+#define SIM_AC_FREQ     50.         // Hz
+#define SIM_VREF        2048        // ADC counts
+
+// Peak amplitude (ADC counts) of the tension and of the first current (the current i gets 1 / (i + 1) of it),
+// and phase shift (rad) between two currents
+#define SIM_TENSION_AMPLITUDE   788.
+#define SIM_CURRENT_AMPLITUDE   600.
+#define SIM_CURRENT_PHASE_STEP  -0.35
+
+
+// Generator of TYPE2 DMA frames: 50 Hz tension with harmonics and phase-shifted currents
+class AdcSimulator
+{
+public:
+    AdcSimulator(const uint8_t* adcChannels);
+    ~AdcSimulator() {};
+    void setFrequency(float freq);
+    uint32_t fill(uint8_t* frame, uint32_t size);
+
+private:
+    uint16_t sample(uint8_t channel);
+
+    const uint8_t* m_adcChannels;
+    float m_phase;
+    float m_phaseStep;
+};
+
+#endif      // __ADCSIMULATOR_H
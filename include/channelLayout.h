@@ -0,0 +1,50 @@
+#ifndef __CHANNELLAYOUT_H
+#define __CHANNELLAYOUT_H
+
+#include <stdint.h>
+
+
+// Compile-time description of the ADC channels of a board variant.
+// Logical channels are ordered as the currents, then the tension, then the VREF.
+template <uint8_t NbCurrents>
+struct ChannelLayout {
+    static_assert(NbCurrents > 0 && NbCurrents + 2 <= 10, "ADC1 has 10 channels");
+
+    static constexpr uint8_t nbCurrents = NbCurrents;
+    static constexpr uint8_t nbChannels = NbCurrents + 2;
+    static constexpr uint8_t tensionId = NbCurrents;
+    static constexpr uint8_t vrefId = NbCurrents + 1;
+
+    // True if all the channels exist on ADC1 (0 to 9)
+    static constexpr bool onAdc1(const uint8_t (&adcChannels)[nbChannels])
+    {
+        for (uint8_t channel : adcChannels) {
+            if (channel >= 10) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+// 5 CT clamps board: currents on ADC1 channels 0-4, tension on 5, VREF on 6
+struct Layout5Ct : ChannelLayout<5> {
+    static constexpr uint8_t adcChannels[nbChannels] = {0, 1, 2, 3, 4, 5, 6};
+    static_assert(onAdc1(adcChannels), "ADC1 has channels 0 to 9");
+
+    // 5 currents channels and 1 tension (y = A . x + B)
+    static constexpr float calibA[nbCurrents + 1] = {0.0387, 0.0168, 0.0162, 0.0233, 0.0538, 0.412572};
+    static constexpr float calibB[nbCurrents + 1] = {0., 0., 0., 0., 0., 0.}; //{0.014, -0.006, -0.054, -0.0515, 0.0395, 0.2065};
+};
+
+
+// Layout the firmware is built for (can be overridden with -DCHANNEL_LAYOUT=...)
+#ifndef CHANNEL_LAYOUT
+#define CHANNEL_LAYOUT Layout5Ct
+#endif
+
+using ActiveLayout = CHANNEL_LAYOUT;
+static_assert(ActiveLayout::onAdc1(ActiveLayout::adcChannels), "ADC1 has channels 0 to 9");
+
+#endif      // __CHANNELLAYOUT_H
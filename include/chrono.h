@@ -2,10 +2,14 @@
 #define __CHRONO_H
 
 #include <string>
-#include <cJSON.h>
 #include <atomic>
 
+#include "jsonWriter.h"
 
+
+// Cycle time statistics of a processing stage. The statistics of each printFreq cycles are
+// merged into global statistics, which readers of any task copy consistently (sequence lock):
+// the task that times the cycles never waits for them.
 class Chrono
 {
 public:
@@ -13,9 +17,19 @@ public:
     ~Chrono();
     void startCycle();
     void endCycle();
-    std::string getGlobalStats();
+    void writeGlobalStats(JsonWriter &writer);
+    uint32_t getVersion() {return m_version.load(std::memory_order_acquire);}     // Changes each time the global statistics are updated
 
 private:
+    struct Totals {
+        int iter;                   // Merged periods of printFreq cycles
+        int maxTime;
+        int minTime;
+        int meanTime;
+        int nbOverLimit;
+    };
+
+    void readTotals(Totals &totals);
     void print();
     void init();
     void calcGlobal();
@@ -28,13 +42,11 @@ private:
     int m_maxTime = 0;
     int m_minTime = 1000000;
     int m_meanTime = 0;
+    int m_nbOverLimit = 0;
     int m_startTime;
 
-    std::atomic<int> m_totalIter = 0;
-    std::atomic<int> m_totalMaxTime = 0;
-    std::atomic<int> m_totalMinTime = 1000000;
-    std::atomic<int> m_totalMeanTime = 0;
-    std::atomic<int> m_nbOverLimit = 0;
+    Totals m_totals = {0, 0, 1000000, 0, 0};
+    std::atomic<uint32_t> m_version = 0;        // Odd while the timed task merges a period into m_totals
 };
 
 #endif  // __CHRONO_H
@@ -0,0 +1,241 @@
+#ifndef __CURRENTBANK_H
+#define __CURRENTBANK_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "def.h"
+#include "signals.h"
+#include "accumulator.h"
+
+
+// Min, max and time-weighted mean of a per-period value, for N channels. merge is associative,
+// so that statistics of consecutive windows can be combined (see rollup.h).
+template <uint8_t N>
+struct RangeStats
+{
+    float min[N];
+    float max[N];
+    TimeMean mean[N];
+
+    void init()
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            min[i] = 999999.f;
+            max[i] = -999999.f;
+            mean[i].init();
+        }
+    }
+
+    void update(uint8_t i, float val, float periodTime)
+    {
+        min[i] = fminf(min[i], val);
+        max[i] = fmaxf(max[i], val);
+        mean[i].add(val, periodTime);
+    }
+
+    void merge(const RangeStats &other)
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            min[i] = fminf(min[i], other.min[i]);
+            max[i] = fmaxf(max[i], other.max[i]);
+            mean[i].merge(other.mean[i]);
+        }
+    }
+
+    RangeData get(uint8_t i, float duration) const {return RangeData({min[i], max[i], mean[i].get(duration)});}
+};
+
+
+// Per-packet statistics of the RMS current and of the powers of N channels
+template <uint8_t N>
+struct PowerStats
+{
+    RangeStats<N> rms;
+    RangeStats<N> activePower;
+    RangeStats<N> apparentPower;
+    RangeStats<N> reactivePower;
+    RangeStats<N> powerFactor;
+    KahanSum energy[N];         // U.I.dt of the packet (W.h)
+    KahanSum time;              // Duration of the statistics (s)
+
+    void init()
+    {
+        rms.init();
+        activePower.init();
+        apparentPower.init();
+        reactivePower.init();
+        powerFactor.init();
+        time.init();
+        for (uint8_t i = 0; i < N; i++) {
+            energy[i].init();
+        }
+    }
+
+    // Count the elapsed period in the duration of the statistics, once for all the channels
+    void addPeriod(float periodTime)
+    {
+        time.add(periodTime);
+    }
+
+    // Update the statistics of a channel with the RMS current and the active power of the elapsed period.
+    // S = Urms.Irms, Q = sqrt(S² - P²), PF = P / S
+    void update(uint8_t i, float currentRms, float P, float tensionRms, float periodTime)
+    {
+        float S = tensionRms * currentRms;
+        float Q = sqrtf(fmaxf(S * S - P * P, 0.f));
+        float PF = (S > 0.f) ? P / S : 0.f;
+
+        rms.update(i, currentRms, periodTime);
+        activePower.update(i, P, periodTime);
+        apparentPower.update(i, S, periodTime);
+        reactivePower.update(i, Q, periodTime);
+        powerFactor.update(i, PF, periodTime);
+        energy[i].add(P * periodTime / 3600.f);    // The energy is in Wh
+    }
+
+    void merge(const PowerStats &other)
+    {
+        rms.merge(other.rms);
+        activePower.merge(other.activePower);
+        apparentPower.merge(other.apparentPower);
+        reactivePower.merge(other.reactivePower);
+        powerFactor.merge(other.powerFactor);
+        time.merge(other.time);
+        for (uint8_t i = 0; i < N; i++) {
+            energy[i].merge(other.energy[i]);
+        }
+    }
+
+    Current::Data getData(uint8_t i, RangeData range)
+    {
+        float duration = time.get();
+        return Current::Data({
+            rms.get(i, duration),
+            range,
+            activePower.get(i, duration),
+            apparentPower.get(i, duration),
+            reactivePower.get(i, duration),
+            powerFactor.get(i, duration),
+            energy[i].get()
+        });
+    }
+};
+
+
+// Structure-of-arrays bank of all the current channels of a layout, processed in one pass per sample.
+// The channel count, the calibration and the VREF channel are compile-time constants of the layout,
+// so every loop below has a constant trip count and constant coefficients.
+template <typename Layout>
+class CurrentBank
+{
+public:
+    static constexpr uint8_t N = Layout::nbCurrents;
+    static constexpr float SAMPLE_TIME = TIM_PERIOD / 1000000.;      // s
+
+    CurrentBank() {init();}
+    ~CurrentBank() {};
+
+    void init()
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            m_val[i] = 0.f;
+            m_prevVal[i] = 0.f;
+            m_maxVal[i] = -999999.f;
+            m_minVal[i] = 999999.f;
+            m_rmsTemp[i] = 0.f;
+            m_powerTemp[i] = 0.f;
+            m_lastRms[i] = 0.f;
+            m_lastPower[i] = 0.f;
+        }
+        m_stats.init();
+    }
+
+    // Restart the statistics of a packet, keeping the period being accumulated
+    void resetStats()
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            m_maxVal[i] = -999999.f;
+            m_minVal[i] = 999999.f;
+        }
+        m_stats.init();
+    }
+
+    // Set the values of all the current channels from a set of raw ADC samples (VREF subtracted)
+    void setRawVals(const uint16_t* data)
+    {
+        float vref = (float)data[Layout::vrefId];
+
+        #pragma GCC unroll 16
+        for (uint8_t i = 0; i < N; i++) {
+            m_prevVal[i] = m_val[i];
+            m_val[i] = Layout::calibA[i] * ((float)data[i] - vref) + Layout::calibB[i];
+        }
+    }
+
+    // Accumulate I² and U.I of every channel over a whole timer period.
+    // U is the tension sample converted in the same ADC conversion set.
+    void calcSample(float U)
+    {
+        accumulate(U, SAMPLE_TIME);
+    }
+
+    // Same as calcSample for a sample cut by a zero crossing (fraction of the timer period in [0, 1])
+    void calcPartialSample(float U, float fraction)
+    {
+        accumulate(U, SAMPLE_TIME * fraction);
+    }
+
+    // Compute the RMS current and the active power P = mean(U.I) of the elapsed period and update the statistics
+    void calcPeriod(float tensionRms, float periodTime)
+    {
+        float invPeriodTime = 1.f / periodTime;
+        m_stats.addPeriod(periodTime);
+
+        for (uint8_t i = 0; i < N; i++) {
+            float rmsVal = sqrtf(m_rmsTemp[i] * invPeriodTime);
+            float P = m_powerTemp[i] * invPeriodTime;
+            m_rmsTemp[i] = 0.f;
+            m_powerTemp[i] = 0.f;
+            m_stats.update(i, rmsVal, P, tensionRms, periodTime);
+            m_lastRms[i] = rmsVal;
+            m_lastPower[i] = P;
+        }
+    }
+
+    // RMS current and active power of the last complete period
+    float getLastRms(uint8_t i) {return m_lastRms[i];}
+    float getLastPower(uint8_t i) {return m_lastPower[i];}
+
+    Current::Data getData(uint8_t i)
+    {
+        return m_stats.getData(i, RangeData({m_minVal[i], m_maxVal[i], 0.f}));
+    }
+
+private:
+    void accumulate(float U, float deltaT)
+    {
+        float Udt = U * deltaT;
+
+        #pragma GCC unroll 16
+        for (uint8_t i = 0; i < N; i++) {
+            float I = m_val[i];
+            m_maxVal[i] = fmaxf(m_maxVal[i], I);
+            m_minVal[i] = fminf(m_minVal[i], I);
+            m_rmsTemp[i] += I * I * deltaT;
+            m_powerTemp[i] += I * Udt;
+        }
+    }
+
+    float m_val[N];
+    float m_prevVal[N];
+    float m_maxVal[N];
+    float m_minVal[N];
+    float m_rmsTemp[N];         // I².dt of the current period (A².s)
+    float m_powerTemp[N];       // U.I.dt of the current period (J)
+    float m_lastRms[N];         // Values of the last complete period
+    float m_lastPower[N];
+    PowerStats<N> m_stats;
+};
+
+#endif      // __CURRENTBANK_H
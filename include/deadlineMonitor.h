@@ -0,0 +1,78 @@
+#ifndef __DEADLINEMONITOR_H
+#define __DEADLINEMONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "def.h"
+#include "adcDemux.h"
+
+#define DEADLINE_RING_SIZE          32                          // Frame timestamps kept until the frame is read (power of two)
+#define DEADLINE_LATENCY_BUDGET     (2 * ADC_BLOCK_PERIOD)      // µs between the end of a frame and its read (the driver pool holds 4 frames)
+#define DEADLINE_JITTER_BUDGET      (ADC_BLOCK_PERIOD / 4)      // µs of deviation of a frame interval from ADC_BLOCK_PERIOD
+#define DEADLINE_JITTER_BINS        10
+
+
+// Deadline monitor of the acquisition: the conversion-done ISR timestamps each DMA frame, and
+// the ADC task checks each frame it reads against these timestamps:
+//  - dropped frames: the driver pool was full (ISR pool overflow), the conversions are lost
+//  - missed frames: an interval of two frame periods or more without a frame
+//  - late frames: read more than DEADLINE_LATENCY_BUDGET after their end
+//  - jitter: deviation of each frame interval from ADC_BLOCK_PERIOD (histogram), over budget counted
+// Each of them raises a PERFORMANCE_ERROR. The timestamps also give the real sample period,
+// which the measure assumes to be TIM_PERIOD. The ISR and the ADC task run on the same core.
+class DeadlineMonitor
+{
+public:
+    DeadlineMonitor();
+    ~DeadlineMonitor() {};
+
+    void frameDone();                           // ISR: a DMA frame is complete
+    void frameDropped();                        // ISR: the last complete frame did not fit in the driver pool
+    void frameRead(uint32_t size);              // ADC task: bytes read from the driver
+
+    uint32_t getNbFrames() {return m_nbFrames.load(std::memory_order_relaxed);}
+    uint32_t getNbDropped() {return m_nbDropped.load(std::memory_order_relaxed);}
+    uint32_t getNbMissed() {return m_nbMissed.load(std::memory_order_relaxed);}
+    uint32_t getNbLate() {return m_nbLate.load(std::memory_order_relaxed);}
+    uint32_t getNbJitterOver() {return m_nbJitterOver.load(std::memory_order_relaxed);}
+    uint32_t getNbUnmonitored() {return m_nbUnmonitored.load(std::memory_order_relaxed);}
+    uint32_t getMaxLatency() {return m_maxLatency.load(std::memory_order_relaxed);}
+    uint32_t getMaxJitter() {return m_maxJitter.load(std::memory_order_relaxed);}
+    float getSamplePeriod() {return m_samplePeriod.load(std::memory_order_relaxed);}
+    uint32_t getJitterCount(uint8_t bin) {return m_jitterBins[bin].load(std::memory_order_relaxed);}
+    static uint32_t getJitterBound(uint8_t bin);
+
+private:
+    struct Frame {
+        int64_t time;                           // µs, end of the frame
+        bool dropped;
+    };
+
+    void checkFrame(const Frame &frame, int64_t now);
+
+    // Written by the ISR
+    Frame m_frames[DEADLINE_RING_SIZE];
+    std::atomic<uint32_t> m_nbFrames;
+    std::atomic<uint32_t> m_nbDropped;
+
+    // Written by the ADC task
+    uint32_t m_nextFrame;                       // Next frame to be read
+    uint32_t m_readBytes;                       // Bytes of the next frame already read
+    int64_t m_firstTime;                        // µs, first frame of the chain of intervals
+    int64_t m_prevTime;                         // µs, 0 if the chain is broken
+    uint32_t m_nbPeriods;                       // Frame periods between the first and the last frame
+    std::atomic<uint32_t> m_nbMissed;
+    std::atomic<uint32_t> m_nbLate;
+    std::atomic<uint32_t> m_nbJitterOver;
+    std::atomic<uint32_t> m_nbUnmonitored;      // Frames overwritten in the ring before they were read
+    std::atomic<uint32_t> m_maxLatency;         // µs
+    std::atomic<uint32_t> m_maxJitter;          // µs
+    std::atomic<float> m_samplePeriod;          // µs, measured
+    std::atomic<uint32_t> m_jitterBins[DEADLINE_JITTER_BINS];
+};
+
+extern DeadlineMonitor deadlineMonitor;
+
+#endif      // __DEADLINEMONITOR_H
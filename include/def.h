@@ -7,18 +7,69 @@
 
 #define DEL_OBJ(x) if(x) {delete x;x=nullptr;}
 
+#include <sdkconfig.h>
+
+#include "channelLayout.h"
+
 // ADC configuration
 #define NB_SAMPLES      128
 #define ANALYZED_PERIOD 20.480                                  // ms (A little bit more than 1/50Hz = 20ms)
-#define NB_CURRENTS     5
-#define NB_CHANNELS     (NB_CURRENTS + 2)
+#define NB_CURRENTS     (ActiveLayout::nbCurrents)
+#define NB_CHANNELS     (ActiveLayout::nbChannels)
 #define SAMPLE_RATE     (1000 / ANALYZED_PERIOD * NB_SAMPLES)
 #define TIM_PERIOD      (ANALYZED_PERIOD * 1000 / NB_SAMPLES)     // µs
-#define TENSION_ID      (NB_CURRENTS + 0)
-#define VREF_ID         (NB_CURRENTS + 1)
+#define TENSION_ID      (ActiveLayout::tensionId)
+#define VREF_ID         (ActiveLayout::vrefId)
+
+// DSP configuration
+#ifndef DSP_FIXED_POINT
+#define DSP_FIXED_POINT false       // Integer accumulation of the current channels only (see fixedCurrentBank.h)
+#endif
+
+// Profiling configuration: latency probes of the processing stages (see profiler.h), CONFIG_METER_PROFILING
+// in menuconfig (Current meter), off by default
+#ifndef PROFILING
+#ifdef CONFIG_METER_PROFILING
+#define PROFILING true
+#else
+#define PROFILING false
+#endif
+#endif
 
 // Measure configuration
 #define MEASURE_PACKET_PERIOD   (5 * 60)             // 5 minutes in seconds
+#define PACKET_RING_SIZE        64                   // Packets kept until they are read (5h20 of measures)
+#define PACKET_RING_OVERWRITE   true                 // When the ring is full, overwrite the oldest packet (else drop the newest)
+
+// Flash log configuration
+#define FLASH_LOG_PARTITION     "measlog"            // Data partition of the log (see partitions.csv)
+#define FLASH_LOG_BATCH         3                    // Packets written at once (at most 15 minutes lost on a power cut)
+
+// Energy registers configuration
+#define ENERGY_CHECKPOINT_PERIOD    (15 * 60)        // s between NVS checkpoints (96 blob writes a day at most: decades of NVS wear)
+
+// Rollup configuration: windows kept by tier (see rollup.h)
+#define ROLLUP_1S_RING_SIZE     64                   // 1 min of 1 s windows
+#define ROLLUP_1M_RING_SIZE     64                   // 1 h of 1 min windows
+#define ROLLUP_5M_RING_SIZE     32                   // 2 h 40 of 5 min windows
+#define ROLLUP_1H_RING_SIZE     32                   // 32 h of 1 h windows
+
+// Live stream configuration
+#define LIVE_STREAM_RING_SIZE   64                   // Periods buffered between the DSP task and the stream task (1.3 s at 50 Hz)
+#define LIVE_STREAM_BATCH       5                    // Periods per WebSocket message (10 messages/s at 50 Hz)
+#define LIVE_STREAM_MAX_CLIENTS 4
+
+// Task placement (see taskTable.cpp): the DSP task alone on its core, the acquisition, network and storage on the other
+#define DSP_CORE                1
+#define SYSTEM_CORE             0
+
+// HTTP configuration: requests served by a pool of workers (see httpHandler.h)
+#define HTTP_NB_WORKERS         2
+#define HTTP_QUEUE_DEPTH        4                    // Requests waiting for a worker, the next ones get a 503
+
+// Error manager configuration
+#define ERROR_RING_SIZE         64                   // Last errors kept (2 kB)
+#define ERROR_RATE_LIMIT        10                   // Errors of a code recorded per second, the others are only counted
 
 // Network configuration
 #define WIFI_SSID "Livebox-Florelie"
@@ -31,13 +82,7 @@
 #define TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"
 
 // Robustness protections
-#define MIN_AC_FREQ   40.          // Hz
-#define MAX_AC_FREQ   60.          // Hz
-
-// 5 currents channels and 1 tension (y = A . x + B)
-const float CALIB_A_COEFFS[] = {0.0387, 0.0168, 0.0162, 0.0233, 0.0538, 0.412572};       // 5 currents channels and 1 tension (y = A . x + B)
-const float CALIB_B_COEFFS[] = {0., 0., 0., 0., 0., 0.}; //{0.014, -0.006, -0.054, -0.0515, 0.0395, 0.2065};
-
-
+#define MIN_AC_FREQ   40.f         // Hz
+#define MAX_AC_FREQ   60.f         // Hz
 
 #endif      // __DEF_H
@@ -0,0 +1,68 @@
+#ifndef __ENERGYREGISTERS_H
+#define __ENERGYREGISTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "def.h"
+#include "liveStream.h"
+
+#define ENERGY_NVS_NAMESPACE    "energy"
+#define ENERGY_NVS_KEY          "registers"         // Key prefix, suffixed with the version and NB_CURRENTS
+#define ENERGY_NVS_VERSION      1
+#define ENERGY_NVS_KEY_SIZE     16                  // NVS_KEY_NAME_MAX_SIZE
+#define ENERGY_FRAC_BITS        32                  // Q32.32 W.h: 4 GW.h range, 0.84 µJ resolution
+
+
+// Monotonic import and export energy registers of each current channel, never reset.
+// The registers are 64-bit fixed point W.h (ENERGY_FRAC_BITS), updated by the DSP task with the
+// energy of each period (its mean active power times its duration, rather than sample by sample:
+// the mean power of the period is already exact). Readers get a consistent copy of all the
+// registers (sequence lock), and the registers are checkpointed to NVS at most every
+// ENERGY_CHECKPOINT_PERIOD, then restored at boot: a power cut loses at most one checkpoint period
+// of energy. Each layout (version, NB_CURRENTS) has its own key, so a firmware with another layout
+// starts new registers and keeps the old ones. If the restore fails, the registers are never
+// checkpointed, so that the stored ones are not overwritten by registers started from 0.
+class EnergyRegisters
+{
+public:
+    struct Values {
+        uint64_t importEnergy[NB_CURRENTS];
+        uint64_t exportEnergy[NB_CURRENTS];
+    };
+
+    EnergyRegisters();
+    ~EnergyRegisters() {};
+    bool begin();
+    void addPeriod(const PeriodFrame &frame);
+    void read(Values &values);
+    bool checkpoint();
+
+    static double toWh(uint64_t reg) {return (double)reg / (double)(1ull << ENERGY_FRAC_BITS);}
+
+    // Statistics
+    bool isRestored() {return m_restored;}
+    uint32_t getNbCheckpoints() {return m_nbCheckpoints;}
+    uint32_t getNbCheckpointErrors() {return m_nbCheckpointErrors;}
+    int64_t getLastCheckpointTime() {return m_lastCheckpointTime;}
+
+private:
+    struct Checkpoint {
+        uint16_t version;
+        uint16_t nbCurrents;
+        Values values;
+    };
+
+    Values m_values;
+    std::atomic<uint32_t> m_version;        // Odd while the DSP task writes the registers
+    Values m_saved;                         // Values of the last checkpoint
+    bool m_restored;                        // false: checkpoints are disabled
+    int64_t m_lastCheckpointTime;           // µs since the start
+    uint32_t m_nbCheckpoints;
+    uint32_t m_nbCheckpointErrors;
+};
+
+extern EnergyRegisters energyRegisters;
+
+#endif      // __ENERGYREGISTERS_H
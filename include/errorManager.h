@@ -1,8 +1,12 @@
 #ifndef __ERRORMANAGER_H
 #define __ERRORMANAGER_H
 
-#include <list>
-#include <string>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "def.h"
+#include "jsonWriter.h"
 
 typedef enum {
     GENERIC_ERROR = 0,
@@ -10,26 +14,77 @@ typedef enum {
     IMPOSSIBLE_VALUE_ERROR,
     PERFORMANCE_ERROR,
     AC_FREQ_ERROR,
-    TENSION_ERROR
+    TENSION_ERROR,
+    NB_ERROR_CODES
 } ErrorCode;
 
+typedef enum {
+    MEASURE_SOURCE = 0,
+    TENSION_SOURCE,
+    FLASH_LOG_SOURCE,
+    ROLLUP_SOURCE,
+    ENERGY_SOURCE,
+    ADC_SOURCE,
+    TASKS_SOURCE,
+    HTTP_SOURCE,
+    NB_ERROR_SOURCES
+} ErrorSource;
+
+
+// Structured error, without allocation: the message must be a string literal
+struct ErrorRecord
+{
+    int64_t time;                   // µs since the start
+    const char* message;
+    float value;                    // Faulty value (frequency, point, size...)
+    uint8_t code;                   // ErrorCode
+    uint8_t source;                 // ErrorSource
+};
+
+
+// Bounded ring of the last errors, written without lock nor allocation from any task or ISR.
+// Each code is rate-limited to ERROR_RATE_LIMIT records per second, so that a noisy signal
+// cannot flood the ring nor the log; every error is still counted by code. Readers page
+// through the ring by sequence number, and skip the slots overwritten while they are read.
+// A writer reserves a sequence number, writes its slot, then publishes it: the published next
+// sequence number only moves over written slots, so a reader never sees a record before it exists.
 class ErrorManager
 {
 public:
-    ErrorManager() {};
+    ErrorManager();
     ~ErrorManager() {}
 
-    void error(ErrorCode errorType, std::string className, std::string errorMsg);
-    std::string getJson();
+    void error(ErrorCode code, ErrorSource source, const char* message, float value = 0.f);
+    size_t writeJson(JsonWriter &writer, uint32_t since, size_t limit);
+
+    uint32_t getNextSeq() {return m_nextSeq.load(std::memory_order_relaxed);}
+    uint32_t getCount(ErrorCode code) {return m_counters[code].count.load(std::memory_order_relaxed);}
+    uint32_t getNbSuppressed(ErrorCode code) {return m_counters[code].suppressed.load(std::memory_order_relaxed);}
+
+    static const char* getCodeName(ErrorCode code);
+    static const char* getSourceName(ErrorSource source);
 
 private:
-    typedef struct {
-        ErrorCode errorType;
-        std::string className;
-        std::string errorMsg;
-    } Error;
+    struct Slot {
+        std::atomic<uint32_t> version;          // Odd while the record is written
+        uint32_t seq;
+        ErrorRecord record;
+    };
+
+    struct Counters {
+        std::atomic<uint32_t> count;            // All the errors of the code
+        std::atomic<uint32_t> suppressed;       // Errors over the rate limit (not recorded)
+        std::atomic<uint32_t> windowSecond;     // Second of the rate limit window
+        std::atomic<uint32_t> windowCount;      // Errors in the window
+    };
+
+    bool read(uint32_t seq, ErrorRecord &record);
+    void publish();
 
-    std::list<Error> m_errors;
+    Slot m_slots[ERROR_RING_SIZE];
+    Counters m_counters[NB_ERROR_CODES];
+    std::atomic<uint32_t> m_reservedSeq;        // Next sequence number given to a writer
+    std::atomic<uint32_t> m_nextSeq;            // Records before this one are written (published to the readers)
 };
 
 extern ErrorManager errorManager;
@@ -0,0 +1,157 @@
+#ifndef __FIXEDCURRENTBANK_H
+#define __FIXEDCURRENTBANK_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "def.h"
+#include "currentBank.h"
+
+#define Q15_SHIFT   15
+#define Q15_ONE     (1 << Q15_SHIFT)
+
+
+// Integer counterpart of CurrentBank: the samples stay raw ADC counts (VREF subtracted) and the
+// per-period sums of x, x² and x.u are kept in int64 accumulators, in count² x timer periods.
+// The calibration y = A . x + B is only applied once per period, when the sums are converted
+// to the RMS current and the active power, so the current channels do not touch the FPU per sample.
+// Limitation: the rest of the sample path stays in float. The tension is calibrated, checked for a
+// zero crossing and accumulated by Tension (a float MAC), and the resampler interpolates every sample;
+// the conversion of the sums to float happens once per period (live stream, registers, statistics).
+template <typename Layout>
+class FixedCurrentBank
+{
+public:
+    static constexpr uint8_t N = Layout::nbCurrents;
+    static constexpr float SAMPLE_TIME = TIM_PERIOD / 1000000.;      // s
+
+    FixedCurrentBank() {init();}
+    ~FixedCurrentBank() {};
+
+    void init()
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            m_raw[i] = 0;
+            m_maxRaw[i] = INT32_MIN;
+            m_minRaw[i] = INT32_MAX;
+            m_sumX[i] = 0;
+            m_sumXX[i] = 0;
+            m_sumXU[i] = 0;
+            m_lastRms[i] = 0.f;
+            m_lastPower[i] = 0.f;
+        }
+        m_sumU = 0;
+        m_stats.init();
+    }
+
+    // Restart the statistics of a packet, keeping the period being accumulated
+    void resetStats()
+    {
+        for (uint8_t i = 0; i < N; i++) {
+            m_maxRaw[i] = INT32_MIN;
+            m_minRaw[i] = INT32_MAX;
+        }
+        m_stats.init();
+    }
+
+    // Set the raw values (VREF subtracted) of all the current channels from a set of raw ADC samples
+    void setRawVals(const uint16_t* data)
+    {
+        int32_t vref = data[Layout::vrefId];
+
+        #pragma GCC unroll 16
+        for (uint8_t i = 0; i < N; i++) {
+            m_raw[i] = (int32_t)data[i] - vref;
+        }
+    }
+
+    // Accumulate x, x² and x.u of every channel over a whole timer period.
+    // u is the raw tension sample (VREF subtracted) converted in the same ADC conversion set.
+    void calcSample(int32_t u)
+    {
+        m_sumU += u;
+
+        #pragma GCC unroll 16
+        for (uint8_t i = 0; i < N; i++) {
+            int32_t x = m_raw[i];
+            m_maxRaw[i] = (x > m_maxRaw[i]) ? x : m_maxRaw[i];
+            m_minRaw[i] = (x < m_minRaw[i]) ? x : m_minRaw[i];
+            m_sumX[i] += x;
+            m_sumXX[i] += x * x;
+            m_sumXU[i] += x * u;
+        }
+    }
+
+    // Same as calcSample for a sample cut by a zero crossing (fraction of the timer period in [0, 1])
+    void calcPartialSample(int32_t u, float fraction)
+    {
+        int64_t w = (int64_t)(fraction * Q15_ONE);
+        m_sumU += (u * w) >> Q15_SHIFT;
+
+        for (uint8_t i = 0; i < N; i++) {
+            int32_t x = m_raw[i];
+            m_maxRaw[i] = (x > m_maxRaw[i]) ? x : m_maxRaw[i];
+            m_minRaw[i] = (x < m_minRaw[i]) ? x : m_minRaw[i];
+            m_sumX[i] += (x * w) >> Q15_SHIFT;
+            m_sumXX[i] += (x * x * w) >> Q15_SHIFT;
+            m_sumXU[i] += (x * u * w) >> Q15_SHIFT;
+        }
+    }
+
+    // Convert the sums of the elapsed period to the RMS current and the active power and update the statistics.
+    // With I = A.x + B and U = Au.u + Bu:
+    //   mean(I²)  = A².mean(x²) + 2.A.B.mean(x) + B²
+    //   mean(U.I) = A.Au.mean(x.u) + A.Bu.mean(x) + B.Au.mean(u) + B.Bu
+    void calcPeriod(float tensionRms, float periodTime)
+    {
+        constexpr float Au = Layout::calibA[Layout::tensionId];
+        constexpr float Bu = Layout::calibB[Layout::tensionId];
+
+        float invNbSamples = SAMPLE_TIME / periodTime;
+        m_stats.addPeriod(periodTime);
+        float meanU = (float)m_sumU * invNbSamples;
+        m_sumU = 0;
+
+        for (uint8_t i = 0; i < N; i++) {
+            float A = Layout::calibA[i];
+            float B = Layout::calibB[i];
+            float meanX = (float)m_sumX[i] * invNbSamples;
+            float meanXX = (float)m_sumXX[i] * invNbSamples;
+            float meanXU = (float)m_sumXU[i] * invNbSamples;
+            m_sumX[i] = 0;
+            m_sumXX[i] = 0;
+            m_sumXU[i] = 0;
+
+            float rmsVal = sqrtf(fmaxf(A * A * meanXX + 2.f * A * B * meanX + B * B, 0.f));
+            float P = A * Au * meanXU + A * Bu * meanX + B * Au * meanU + B * Bu;
+            m_stats.update(i, rmsVal, P, tensionRms, periodTime);
+            m_lastRms[i] = rmsVal;
+            m_lastPower[i] = P;
+        }
+    }
+
+    // RMS current and active power of the last complete period
+    float getLastRms(uint8_t i) {return m_lastRms[i];}
+    float getLastPower(uint8_t i) {return m_lastPower[i];}
+
+    Current::Data getData(uint8_t i)
+    {
+        float minVal = Layout::calibA[i] * (float)m_minRaw[i] + Layout::calibB[i];
+        float maxVal = Layout::calibA[i] * (float)m_maxRaw[i] + Layout::calibB[i];
+        return m_stats.getData(i, RangeData({fminf(minVal, maxVal), fmaxf(minVal, maxVal), 0.f}));
+    }
+
+private:
+    int32_t m_raw[N];
+    int32_t m_maxRaw[N];
+    int32_t m_minRaw[N];
+    int64_t m_sumX[N];          // sum of x over the current period (count)
+    int64_t m_sumXX[N];         // sum of x² over the current period (count²)
+    int64_t m_sumXU[N];         // sum of x.u over the current period (count²)
+    int64_t m_sumU;             // sum of u over the current period (count)
+    float m_lastRms[N];         // Values of the last complete period
+    float m_lastPower[N];
+    PowerStats<N> m_stats;
+};
+
+#endif      // __FIXEDCURRENTBANK_H
@@ -0,0 +1,88 @@
+#ifndef __FLASHLOG_H
+#define __FLASHLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "def.h"
+#include "flashStorage.h"
+
+#define FLASH_LOG_MAGIC                 0x474C4D45u         // "EMLG"
+#define FLASH_LOG_VERSION               1
+#define FLASH_LOG_SECTOR_HEADER_SIZE    16
+#define FLASH_LOG_SLOT_HEADER_SIZE      8                   // seq, CRC
+
+
+// Append-only log of fixed-size records on a flash area, used as a circular buffer of sectors.
+//
+// Sector: header {magic, version, slot size, sector sequence number, CRC}, then slots
+// {seq, CRC32 of seq + payload, payload}. The record seq lives in the slot seq / slotsPerSector
+// of the sector seq % nbSectors, so a record is found without any index: at boot, only the
+// sector headers and the slots of the newest sector are read. Sectors are erased in turn,
+// which spreads the wear evenly, and records are staged in RAM and written FLASH_LOG_BATCH
+// at a time (and on esp_restart). Sequence numbers may be skipped: the skipped records are
+// reported as missing, not as corrupted.
+class FlashLog
+{
+public:
+    FlashLog(FlashStorage &storage, uint16_t payloadSize);
+    ~FlashLog();
+    bool begin();
+    bool isMounted() {return m_staging != nullptr;}
+
+    bool append(uint32_t seq, const uint8_t* payload);
+    bool flush();
+    bool read(uint32_t seq, uint8_t* payload);
+
+    // Records [firstSeq, nextSeq) may be read (a corrupted one is reported as missing)
+    uint32_t getFirstSeq();
+    uint32_t getNextSeq();
+    size_t getNbSectors() {return m_nbSectors;}
+    uint16_t getSlotsPerSector() {return m_slotsPerSector;}
+    uint32_t getNbCorrupted() {return m_nbCorrupted;}
+    uint32_t getNbErased() {return m_nbErased;}
+    uint32_t getNbWriteErrors() {return m_nbWriteErrors;}
+
+private:
+    struct SectorHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t slotSize;
+        uint32_t sectorSeq;
+        uint32_t crc;
+    };
+
+    bool readSectorHeader(size_t sector, SectorHeader &header);
+    bool openSector(uint32_t sectorSeq);
+    bool flushLocked();
+    uint32_t getFirstSeqLocked();
+    size_t slotOffset(uint32_t seq);
+    uint32_t slotCrc(const uint8_t* slot);
+
+    FlashStorage &m_storage;
+    uint16_t m_payloadSize;
+    uint16_t m_slotSize;
+    size_t m_sectorSize;
+    size_t m_nbSectors;
+    uint16_t m_slotsPerSector;
+    uint8_t* m_staging;                 // Records [m_flushedSeq, m_nextSeq) not written yet
+    uint32_t m_flushedSeq;
+    uint32_t m_nextSeq;
+    uint32_t m_openSectorSeq;           // Sector being filled (UINT32_MAX if none)
+    std::mutex m_mutex;
+    uint32_t m_nbCorrupted;
+    uint32_t m_nbErased;
+    uint32_t m_nbWriteErrors;
+};
+
+extern FlashLog flashLog;
+extern TaskHandle_t logTaskHandle;
+
+uint32_t log_init();
+void log_task(void *pvParameters);
+
+#endif      // __FLASHLOG_H
@@ -0,0 +1,21 @@
+#ifndef __FLASHSTORAGE_H
+#define __FLASHSTORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Raw NOR flash area: erased bytes read 0xFF, writes can only clear bits and erases work on whole sectors.
+// The log only talks to this interface, so that it can run on a file-backed emulator on a host.
+class FlashStorage
+{
+public:
+    virtual ~FlashStorage() {};
+    virtual size_t getSize() = 0;
+    virtual size_t getSectorSize() = 0;
+    virtual bool read(size_t offset, void* data, size_t size) = 0;
+    virtual bool write(size_t offset, const void* data, size_t size) = 0;
+    virtual bool eraseSector(size_t sector) = 0;
+};
+
+#endif      // __FLASHSTORAGE_H
@@ -0,0 +1,79 @@
+#ifndef __HARMONICS_H
+#define __HARMONICS_H
+
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "def.h"
+#include "signals.h"
+#include "spscRing.h"
+
+#define NB_FFT_CHANNELS     2                                   // Current channels analyzed along with the tension
+#define FFT_CURRENT_IDS     {0, 1}                              // Current channels analyzed
+#define NB_HARMONICS        10                                  // Ranks 1 (fundamental) to NB_HARMONICS
+#define PERIOD_RING_SIZE    4
+#define RESULT_RING_SIZE    4
+
+
+// One mains period resampled to NB_SAMPLES points: the tension first, then the analyzed currents
+struct PeriodBuffer {
+    float samples[NB_FFT_CHANNELS + 1][NB_SAMPLES];
+};
+
+// Harmonic content of the analyzed channels over one period, handed back to the DSP task
+struct PeriodHarmonics {
+    float thd[NB_FFT_CHANNELS + 1];                             // %
+    float harmonics[NB_FFT_CHANNELS + 1][NB_HARMONICS];         // % of the fundamental
+};
+
+// Harmonic content of a channel over a packet
+struct HarmonicData {
+    RangeData thd;                      // %
+    float harmonics[NB_HARMONICS];      // Mean amplitude of each rank (% of the fundamental)
+};
+
+
+// The DSP task hands the periods to the harmonic task through one lock-free ring, and gets
+// the results back through another one: the statistics are only touched by the DSP task.
+class Harmonics
+{
+public:
+    Harmonics();
+    ~Harmonics() {};
+
+    // Sampling side (DSP task): returns nullptr if the ring is full (the period is skipped)
+    PeriodBuffer* beginPeriod();
+    void endPeriod();
+    void getData(HarmonicData* data);
+
+    // Analysis side (harmonic task)
+    void process();
+
+    uint32_t getNbSkipped() {return m_ring.getNbOverrun();}
+    static void writeJson(JsonWriter &writer, const char* key, const HarmonicData &data);
+
+private:
+    void init();
+    void analyze(const float* samples, float* magnitudes);
+    void collect();
+
+    SpscRing<PeriodBuffer, PERIOD_RING_SIZE> m_ring;
+    SpscRing<PeriodHarmonics, RESULT_RING_SIZE> m_results;
+    float m_coeffs[NB_HARMONICS];         // Goertzel coefficient of each rank
+
+    // Statistics since the last getData (DSP task only)
+    uint32_t m_nbPeriods;
+    float m_thdMin[NB_FFT_CHANNELS + 1];
+    float m_thdMax[NB_FFT_CHANNELS + 1];
+    float m_thdSum[NB_FFT_CHANNELS + 1];
+    float m_harmonicSum[NB_FFT_CHANNELS + 1][NB_HARMONICS];
+};
+
+extern Harmonics harmonics;
+extern TaskHandle_t harmonicTaskHandle;
+
+void harmonic_task(void *pvParameters);
+
+#endif      // __HARMONICS_H
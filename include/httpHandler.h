@@ -1,34 +1,78 @@
-/*#ifndef __HTTPHANDLER_H
+#ifndef __HTTPHANDLER_H
 #define __HTTPHANDLER_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
 #include "esp_http_server.h"
 
+#include "def.h"
+#include "accumulator.h"
+
+#define HTTP_MAX_ENDPOINTS      24
+
+
+// Asynchronous request layer: the server task hands each request over to a pool of worker tasks
+// through a bounded queue (httpd_req_async_handler_begin), and answers 503 at once when the queue
+// is full, so it never blocks on the serialization of a response. The workers wait on the queue
+// (no polling). Each endpoint keeps its request counters and latencies (queue wait included).
 class HttpHandler
 {
-private:
+public:
     typedef esp_err_t (*HandlerFunction)(httpd_req_t *req);
 
-    struct RequestData {
-        httpd_req_t *req;
-        bool new_request;
+    struct Stats {
+        const char* uri;
+        uint32_t nbRequests;
+        uint32_t nbRejected;                // Queue full: 503
+        uint32_t nbFailed;                  // Handler error: connection closed
+        float meanLatency;                  // ms, from the handoff to the end of the handler
+        float maxLatency;                   // ms
+        float maxWait;                      // ms in the queue
+    };
+
+    HttpHandler();
+    ~HttpHandler() {};
+    bool begin();
+    esp_err_t registerUri(httpd_handle_t server, const char* uri, httpd_method_t method, HandlerFunction handler);
+    void task();
+
+    size_t getNbEndpoints() {return m_nbEndpoints;}
+    void getStats(size_t endpoint, Stats &stats);
+
+private:
+    struct Endpoint {
+        const char* uri;
         HandlerFunction handler;
+        uint32_t nbRequests;
+        uint32_t nbRejected;
+        uint32_t nbFailed;
+        KahanSum latency;                   // ms
+        float maxLatency;
+        float maxWait;
     };
 
-    RequestData request_data;
-    SemaphoreHandle_t request_mutex;
-    TaskHandle_t task_handle;
-    HandlerFunction handler_function;
+    struct Request {
+        httpd_req_t* req;                   // Copy owned by the worker until it completes
+        Endpoint* endpoint;
+        int64_t time;                       // µs, handoff
+    };
 
-    static void taskWrapper(void* param);
-    void task();
+    static esp_err_t dispatch(httpd_req_t *req);
 
-public:
-    HttpHandler(HandlerFunction handler);
-    ~HttpHandler();
-    void start();
-    esp_err_t handleRequest(httpd_req_t *req);
+    QueueHandle_t m_queue;
+    Endpoint m_endpoints[HTTP_MAX_ENDPOINTS];
+    size_t m_nbEndpoints;
+    std::mutex m_statsMutex;
 };
 
+extern HttpHandler httpHandler;
+extern TaskHandle_t httpWorkerHandles[HTTP_NB_WORKERS];
+
+void http_worker_task(void *pvParameters);
+
 #endif      // __HTTPHANDLER_H
-*/
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __JSONWRITER_H
+#define __JSONWRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_CHUNK_SIZE     512         // Bytes formatted before they are handed to the sink
+#define JSON_MAX_DEPTH      32
+
+
+// Sink of the formatted JSON (e.g. an HTTP chunk): returns false if the bytes could not be sent
+typedef bool (*JsonSink)(void* ctx, const char* data, size_t size);
+
+
+// Streaming writer of compact JSON into a small fixed buffer, flushed to a sink each time it is full.
+// Its memory use does not depend on the size of the document. Numbers are formatted like cJSON does,
+// and keys and strings are written as is (no escaping). Once the sink fails, everything else is ignored.
+class JsonWriter
+{
+public:
+    JsonWriter(JsonSink sink, void* ctx);
+    ~JsonWriter() {};
+
+    void beginObject(const char* key = nullptr);
+    void endObject();
+    void beginArray(const char* key = nullptr);
+    void endArray();
+    void addNumber(const char* key, double val);
+    void addNumberArray(const char* key, const float* vals, size_t nbVals);
+    void addString(const char* key, const char* val);
+    void addBool(const char* key, bool val);
+
+    bool flush();
+    bool isOk() {return m_ok;}
+
+private:
+    void begin(const char* key, char open);
+    void end(char close);
+    void writeKey(const char* key);
+    void writeNumber(double val);
+    void write(const char* data, size_t size);
+    void write(char c) {write(&c, 1);}
+
+    JsonSink m_sink;
+    void* m_ctx;
+    char m_buffer[JSON_CHUNK_SIZE];
+    size_t m_size;
+    uint32_t m_hasItem;         // Bit d: the container at depth d already has an item (a comma is due)
+    uint8_t m_depth;
+    bool m_ok;
+};
+
+#endif      // __JSONWRITER_H
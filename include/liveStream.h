@@ -0,0 +1,105 @@
+#ifndef __LIVESTREAM_H
+#define __LIVESTREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_http_server.h>
+
+#include "def.h"
+#include "spscRing.h"
+
+// Live stream of the per-period values over WebSocket (/api/stream).
+//
+// Message: one binary WebSocket message per batch of periods, all little-endian.
+//   uint16 frameSize           Bytes of a frame (a decoder skips what it does not know)
+//   uint8  nbCurrents
+//   uint8  nbFrames
+//   uint32 nbDropped           Frames lost by this client since it subscribed
+//   then nbFrames frames:
+//   uint32 seq                 Period number since the start (a gap shows lost frames)
+//   int64  time                µs since the start
+//   float  frequency           Hz
+//   float  tensionRms          V
+//   float  currentRms[nbCurrents]      A
+//   float  activePower[nbCurrents]     W
+#define LIVE_MESSAGE_HEADER_SIZE    8
+#define LIVE_FRAME_SIZE             (20 + 8 * NB_CURRENTS)
+
+
+// Values of one mains period
+struct PeriodFrame
+{
+    uint32_t seq;
+    int64_t time;
+    float frequency;
+    float tensionRms;
+    float currentRms[NB_CURRENTS];
+    float activePower[NB_CURRENTS];
+};
+
+
+// The DSP task pushes a frame per period into a ring, without ever blocking: when the ring is
+// full, the frame is dropped. The stream task sends the frames in batches to each client;
+// a client whose previous batch is still being sent, or whose socket is full, misses the
+// batch, which is counted. The sockets of the clients are written without blocking, so that
+// a slow client never holds the HTTP server task.
+class LiveStream
+{
+public:
+    LiveStream();
+    ~LiveStream() {};
+    void begin(httpd_handle_t server);
+
+    // DSP task side
+    bool isActive() {return m_nbClients.load(std::memory_order_relaxed) > 0;}
+    void push(const PeriodFrame &frame);
+
+    // HTTP server side
+    bool addClient(int fd);
+    void removeClient(int fd);
+
+    void task();
+
+    // Statistics
+    size_t getNbClients() {return m_nbClients.load(std::memory_order_relaxed);}
+    uint32_t getNbFrames() {return m_frames.getNbPushed() + m_frames.getNbOverrun();}
+    uint32_t getNbRingDropped() {return m_frames.getNbOverrun();}
+    uint32_t getNbSent() {return m_nbSent.load(std::memory_order_relaxed);}
+    uint32_t getNbDropped() {return m_nbDropped.load(std::memory_order_relaxed);}
+
+private:
+    struct Client {
+        LiveStream* stream;
+        int fd;                                 // -1 if the slot is free
+        std::atomic<bool> busy;                 // A batch is queued for the HTTP server task
+        uint8_t nbFrames;
+        std::atomic<uint32_t> nbDropped;        // Updated by the stream task and the HTTP server task
+        size_t size;
+        uint8_t message[LIVE_MESSAGE_HEADER_SIZE + LIVE_STREAM_BATCH * LIVE_FRAME_SIZE];
+    };
+
+    size_t encodeBatch(uint8_t* buffer, uint8_t nbFrames);
+    void sendBatch(uint8_t nbFrames);
+    static void sendWork(void* arg);
+
+    httpd_handle_t m_server;
+    SpscRing<PeriodFrame, LIVE_STREAM_RING_SIZE> m_frames;
+    PeriodFrame m_batch[LIVE_STREAM_BATCH];
+    Client m_clients[LIVE_STREAM_MAX_CLIENTS];
+    std::mutex m_mutex;                         // Client table
+    std::atomic<size_t> m_nbClients;
+    std::atomic<uint32_t> m_nbSent;
+    std::atomic<uint32_t> m_nbDropped;
+};
+
+extern LiveStream liveStream;
+extern TaskHandle_t streamTaskHandle;
+
+void stream_task(void *pvParameters);
+
+#endif      // __LIVESTREAM_H
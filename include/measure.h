@@ -3,15 +3,22 @@
 
 #include <math.h>
 #include <stdint.h>
-#include <vector>
 #include <string>
-#include <queue>
-#include <mutex>
+#include <atomic>
 
 #include "def.h"
 #include "signals.h"
+#include "currentBank.h"
+#include "fixedCurrentBank.h"
+#include "adcDemux.h"
+#include "harmonics.h"
+#include "resampler.h"
+#include "packetRing.h"
+#include "packetRecord.h"
+#include "liveStream.h"
+#include "energyRegisters.h"
 
-#define NB_FFT_CHANNELS 2
+#define PACKET_RECORD_SIZE  packetRecordSize(NB_CURRENTS, NB_FFT_CHANNELS + 1, NB_HARMONICS)
 
 #define ADC_BITS            12.
 #define ADC_COEFF_A         (500. / pow(2., ADC_BITS))
@@ -26,37 +33,69 @@ public:
         float duration;
         Tension::Data tension;
         Current::Data currents[NB_CURRENTS];
+        HarmonicData harmonics[NB_FFT_CHANNELS + 1];        // Tension, then the analyzed currents
+        EnergyRegisters::Values energy;                     // Registers at the end of the packet
     };
 
     Measure();
     ~Measure();
     void init();
-    void adcCallback(uint32_t* data);
-    std::string getJsonOld();
-    std::string getJson();
+    bool begin(uint32_t firstSeq);
+    void adcBlockCallback(const AdcBlock &block);
+    void adcCallback(const uint16_t* data);
+    size_t writeJson(JsonWriter &writer, uint32_t since, size_t limit);
+    static void writeJsonFields(JsonWriter &writer, const Data &data);
+    static void encodeRecord(uint8_t* buffer, uint32_t seq, const Data &data);
+    static uint32_t decodeRecord(const uint8_t* buffer, Data &data);
+    size_t writeBinary(uint32_t since, size_t limit, bool (*sink)(void* ctx, const uint8_t* data, size_t size), void* ctx);
     void packetTask();
-    bool popFromQueue(Data &data);
+
+    // Walk the buffered packets in place, the oldest first, without releasing them
+    template <typename F>
+    size_t forEachPacket(F f) {return m_packets.forEach(f);}
+
+    // Packets [firstSeq, nextSeq) may be read, from the ring or else from the flash log
+    bool getPacket(uint32_t seq, Data &data);
+    uint32_t getFirstSeq();
+    uint32_t getNextSeq() {return m_seqBase + m_packets.getNextSeq();}
+    void ack(uint32_t seq);
+    uint32_t getAckedSeq() {return m_ackedSeq.load();}
+
+    // Packet ring statistics
+    size_t getNbPackets() {return m_packets.size();}
+    uint32_t getNbDroppedPackets() {return m_packets.getNbDropped();}
+    size_t getPacketRingBytes() {return m_packets.getBytes();}
+    bool isPacketRingInPsram() {return m_packets.isInPsram();}
 
 
 private:
 
     void save();
+    void fillData(Data &data);
+    void fillPeriod(PeriodFrame &frame);
     typedef enum {
         INIT = 0,
         WAITING_ZC,
         NORMAL_PHASE
     } InitState;
 
-    std::vector<Current> m_currents;
+#if DSP_FIXED_POINT
+    FixedCurrentBank<ActiveLayout> m_currents;
+    int32_t tensionSample() {return m_tension.getRawVal();}
+#else
+    CurrentBank<ActiveLayout> m_currents;
+    float tensionSample() {return m_tension.getVal();}
+#endif
     Tension m_tension;
+    Resampler m_resampler;
     InitState m_initState;
     float m_timerPeriod;
-    float m_totalMeasureTime;
+    KahanSum m_totalMeasureTime;                // Duration of the packet (s)
     float m_periodTime;
-    cJSON* m_data;
-    std::queue<Data> m_fifo;
-    std::mutex m_queueMutex;
-    cJSON* serializeData(Data &data);
+    PacketRing<Data, PACKET_RING_SIZE> m_packets;
+    uint32_t m_seqBase;                         // Sequence number of the first packet of the ring
+    std::atomic<uint32_t> m_ackedSeq;           // Packets before this one are acknowledged by the collector
+    uint32_t m_nbPeriods;                       // Mains periods since the start
     //uint16_t m_iPeriodTimeBuffer;
     //std::vector<float> m_periodTimeBuffer;
 };
@@ -0,0 +1,134 @@
+#ifndef __PACKETRECORD_H
+#define __PACKETRECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Binary export of the measure packets (/api/adc/data.bin).
+// This header only depends on the C library, so that a collector can decode the stream on a host.
+//
+// Stream: one PacketHeader, then fixed-size records, all little-endian. A decoder skips
+// headerSize bytes and reads records of recordSize bytes, so both may grow in later versions.
+// Record (version 2):
+//   uint32 seq                 Sequence number of the packet (cursor of the next request: last seq + 1)
+//   int64  timestamp           s
+//   float  duration            s
+//   float  tension[9]          RMS, range, frequency (min, mean, max each)
+//   float  currents[nbCurrents][19]
+//                              RMS, range, active, apparent, reactive power, power factor
+//                              (min, mean, max each), then the energy
+//   float  harmonics[nbHarmonicChannels][3 + nbHarmonics]
+//                              THD (min, mean, max), then the amplitude of each rank (tension first)
+//   uint64 energy[nbCurrents][2]
+//                              Import and export energy registers, Q32.32 W.h (see energyRegisters.h)
+
+#define PACKET_RECORD_MAGIC         0x4B504D45u         // "EMPK"
+#define PACKET_RECORD_VERSION       2
+#define PACKET_HEADER_SIZE          20
+#define PACKET_RECORD_FIXED_SIZE    16                  // seq, timestamp, duration
+#define PACKET_TENSION_VALUES       9
+#define PACKET_CURRENT_VALUES       19
+#define PACKET_HARMONIC_VALUES(nbHarmonics) (3 + (nbHarmonics))
+#define PACKET_ENERGY_SIZE          16                  // import, export
+
+
+// Size of a record for a given layout
+constexpr uint16_t packetRecordSize(uint8_t nbCurrents, uint8_t nbHarmonicChannels, uint8_t nbHarmonics)
+{
+    return PACKET_RECORD_FIXED_SIZE + 4 * (PACKET_TENSION_VALUES + nbCurrents * PACKET_CURRENT_VALUES
+        + nbHarmonicChannels * PACKET_HARMONIC_VALUES(nbHarmonics)) + nbCurrents * PACKET_ENERGY_SIZE;
+}
+
+
+// Little-endian writer over a byte buffer (the caller sizes the buffer)
+class RecordWriter
+{
+public:
+    RecordWriter(uint8_t* buffer) : m_buffer(buffer), m_pos(0) {};
+
+    void u8(uint8_t val) {m_buffer[m_pos++] = val;}
+    void u16(uint16_t val) {u8(val & 0xFF); u8(val >> 8);}
+    void u32(uint32_t val) {u16(val & 0xFFFF); u16(val >> 16);}
+    void u64(uint64_t val) {u32(val & 0xFFFFFFFF); u32(val >> 32);}
+    void i64(int64_t val) {u64((uint64_t)val);}
+    void f32(float val) {uint32_t bits; memcpy(&bits, &val, 4); u32(bits);}
+    size_t size() const {return m_pos;}
+
+private:
+    uint8_t* m_buffer;
+    size_t m_pos;
+};
+
+
+// Little-endian reader over a byte buffer (the caller checks the size)
+class RecordReader
+{
+public:
+    RecordReader(const uint8_t* buffer) : m_buffer(buffer), m_pos(0) {};
+
+    uint8_t u8() {return m_buffer[m_pos++];}
+    uint16_t u16() {uint16_t lo = u8(); return lo | (uint16_t)(u8() << 8);}
+    uint32_t u32() {uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16);}
+    uint64_t u64() {uint64_t lo = u32(); return lo | ((uint64_t)u32() << 32);}
+    int64_t i64() {return (int64_t)u64();}
+    float f32() {uint32_t bits = u32(); float val; memcpy(&val, &bits, 4); return val;}
+    size_t size() const {return m_pos;}
+
+private:
+    const uint8_t* m_buffer;
+    size_t m_pos;
+};
+
+
+// Header of a binary stream: describes the layout of the records that follow
+struct PacketHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint8_t nbCurrents;
+    uint8_t nbHarmonicChannels;         // Tension included
+    uint8_t nbHarmonics;
+    uint32_t nbDropped;                 // Packets lost by the device since its start
+
+    void encode(uint8_t* buffer) const
+    {
+        RecordWriter writer(buffer);
+        writer.u32(magic);
+        writer.u16(version);
+        writer.u16(headerSize);
+        writer.u16(recordSize);
+        writer.u8(nbCurrents);
+        writer.u8(nbHarmonicChannels);
+        writer.u8(nbHarmonics);
+        writer.u8(0);
+        writer.u16(0);
+        writer.u32(nbDropped);
+    }
+
+    // Returns false if the buffer does not start with a header of a known version
+    bool decode(const uint8_t* buffer, size_t size)
+    {
+        if (size < PACKET_HEADER_SIZE) {
+            return false;
+        }
+        RecordReader reader(buffer);
+        magic = reader.u32();
+        version = reader.u16();
+        headerSize = reader.u16();
+        recordSize = reader.u16();
+        nbCurrents = reader.u8();
+        nbHarmonicChannels = reader.u8();
+        nbHarmonics = reader.u8();
+        reader.u8();
+        reader.u16();
+        nbDropped = reader.u32();
+
+        return magic == PACKET_RECORD_MAGIC && version == PACKET_RECORD_VERSION && headerSize >= PACKET_HEADER_SIZE
+            && recordSize >= packetRecordSize(nbCurrents, nbHarmonicChannels, nbHarmonics);
+    }
+};
+
+#endif      // __PACKETRECORD_H
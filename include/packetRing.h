@@ -0,0 +1,141 @@
+#ifndef __PACKETRING_H
+#define __PACKETRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+#include <esp_heap_caps.h>
+
+
+// Fixed-capacity ring of packets, allocated once at startup (in PSRAM when available).
+// The single producer writes the packets in place and never allocates nor blocks: when the
+// ring is full, the new packet either replaces the oldest one or is dropped, depending on the
+// policy, and the loss is counted. Readers walk the packets in place, or copy one packet, under
+// the read lock; the producer only tries this lock, to evict the oldest packet. Packets are
+// identified by their position since the start (sequence number).
+template <typename T, size_t N>
+class PacketRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "PacketRing capacity must be a power of two");
+
+public:
+    typedef enum {
+        OVERWRITE_OLDEST = 0,
+        DROP_NEWEST
+    } Policy;
+
+    PacketRing(Policy policy) :
+        m_items(nullptr),
+        m_policy(policy),
+        m_inPsram(false)
+    {};
+    ~PacketRing() {heap_caps_free(m_items);};
+
+    // Allocate the storage, in PSRAM if there is some, else in internal RAM
+    bool allocate()
+    {
+        m_items = static_cast<T*>(heap_caps_malloc(N * sizeof(T), MALLOC_CAP_SPIRAM));
+        m_inPsram = (m_items != nullptr);
+        if (m_items == nullptr) {
+            m_items = static_cast<T*>(heap_caps_malloc(N * sizeof(T), MALLOC_CAP_DEFAULT));
+        }
+        return m_items != nullptr;
+    }
+
+    // Producer side: returns the slot of the next packet, or nullptr (and counts a drop) if the packet is dropped
+    T* reserve()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_items == nullptr) {
+            m_nbDropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (head - m_tail.load(std::memory_order_acquire) == N) {
+            // A reader may be walking the oldest packet: never wait for it, drop the new one instead
+            if (m_policy == DROP_NEWEST || !m_readMutex.try_lock()) {
+                m_nbDropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            // A reader may have released packets meanwhile: evict only if the ring is still full
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (head - tail == N) {
+                m_tail.store(tail + 1, std::memory_order_release);
+                m_nbDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_readMutex.unlock();
+        }
+        return &m_items[head & (N - 1)];
+    }
+
+    void commit()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Reader side: call f(const T&) on every buffered packet, oldest first, and keep them
+    template <typename F>
+    size_t forEach(F f)
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        return visit(f);
+    }
+
+    // Reader side: copy the packet of sequence number seq, returns false if it is not buffered
+    bool read(size_t seq, T &item)
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (seq - tail >= m_head.load(std::memory_order_acquire) - tail) {
+            return false;
+        }
+        item = m_items[seq & (N - 1)];
+        return true;
+    }
+
+    // Reader side: release the packets up to the sequence number seq included
+    size_t releaseUntil(size_t seq)
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        if (seq - tail >= head - tail) {
+            return 0;
+        }
+        m_tail.store(seq + 1, std::memory_order_release);
+        return seq + 1 - tail;
+    }
+
+    // Statistics, readable from any task
+    size_t capacity() const {return N;}
+    size_t size() const {return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);}
+    size_t getFirstSeq() const {return m_tail.load(std::memory_order_acquire);}     // Sequence number of the oldest packet
+    size_t getNextSeq() const {return m_head.load(std::memory_order_acquire);}      // Sequence number of the next packet
+    size_t getBytes() const {return (m_items != nullptr) ? N * sizeof(T) : 0;}
+    bool isInPsram() const {return m_inPsram;}
+    uint32_t getNbDropped() const {return m_nbDropped.load(std::memory_order_relaxed);}
+
+private:
+    // The packets in [tail, head) are never written by the producer while the read lock is held
+    template <typename F>
+    size_t visit(F &f)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        for (size_t i = tail; i != head; i++) {
+            f(static_cast<const T&>(m_items[i & (N - 1)]));
+        }
+        return head - tail;
+    }
+
+    T* m_items;
+    Policy m_policy;
+    bool m_inPsram;
+    std::mutex m_readMutex;
+    std::atomic<size_t> m_head = 0;
+    std::atomic<size_t> m_tail = 0;
+    std::atomic<uint32_t> m_nbDropped = 0;
+};
+
+#endif      // __PACKETRING_H
@@ -0,0 +1,28 @@
+#ifndef __PARTITIONFLASH_H
+#define __PARTITIONFLASH_H
+
+#include <esp_partition.h>
+
+#include "flashStorage.h"
+
+
+// Data partition of the SPI flash, found by its label in the partition table
+class PartitionFlash : public FlashStorage
+{
+public:
+    PartitionFlash(const char* label);
+    ~PartitionFlash() {};
+    bool begin();
+
+    size_t getSize() override;
+    size_t getSectorSize() override;
+    bool read(size_t offset, void* data, size_t size) override;
+    bool write(size_t offset, const void* data, size_t size) override;
+    bool eraseSector(size_t sector) override;
+
+private:
+    const char* m_label;
+    const esp_partition_t* m_partition;
+};
+
+#endif      // __PARTITIONFLASH_H
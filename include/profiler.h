@@ -0,0 +1,88 @@
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "def.h"
+#include "jsonWriter.h"
+
+#define PROFILE_SUB_BUCKET_BITS     2                                           // 4 buckets per octave: 19% resolution at most
+#define PROFILE_NB_BUCKETS          ((32 - PROFILE_SUB_BUCKET_BITS + 1) << PROFILE_SUB_BUCKET_BITS)
+
+typedef enum {
+    PROFILE_ACQUISITION = 0,        // Read of a DMA frame from the driver
+    PROFILE_DEMUX,                  // Demultiplexing of a frame into a block
+    PROFILE_BLOCK_DSP,              // Processing of a demultiplexed block, the periods closed in it included
+    PROFILE_PERIOD_DSP,             // Closing of a period (statistics, rollup, registers, stream)
+    PROFILE_PACKET_SAVE,            // Copy of the statistics into a packet
+    PROFILE_SERIALIZATION,          // Encoding of a packet for HTTP (JSON, with the full chunks sent meanwhile, or binary)
+    NB_PROFILE_PROBES
+} ProfileProbe;
+
+
+#if PROFILING
+
+#include <esp_cpu.h>
+
+// Latency histogram in CPU cycles, with log-spaced buckets: the relative error of a percentile
+// does not depend on the latency. Lock-free: any task of any core can record in it.
+struct ProfileHistogram
+{
+    std::atomic<uint32_t> buckets[PROFILE_NB_BUCKETS];
+    std::atomic<uint32_t> max;
+
+    void init();
+    void add(uint32_t cycles);
+
+    static uint8_t getBucket(uint32_t cycles);
+    static uint32_t getUpperBound(uint8_t bucket);
+};
+
+
+// Named latency probes of the acquisition and processing stages, served by /api/profile.
+// With PROFILING false, the probe macros compile out to nothing and so does the profiler.
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler() {};
+
+    void record(ProfileProbe probe, uint32_t cycles) {m_histograms[probe].add(cycles);}
+    void writeJson(JsonWriter &writer);
+    static uint32_t now() {return esp_cpu_get_cycle_count();}
+    static const char* getProbeName(ProfileProbe probe);
+
+private:
+    ProfileHistogram m_histograms[NB_PROFILE_PROBES];
+};
+
+extern Profiler profiler;
+
+
+// Records the cycles spent in the enclosing scope
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileProbe probe) : m_probe(probe), m_start(Profiler::now()) {}
+    ~ProfileScope() {profiler.record(m_probe, Profiler::now() - m_start);}
+
+private:
+    ProfileProbe m_probe;
+    uint32_t m_start;
+};
+
+#define PROFILE_SCOPE(probe)        ProfileScope profileScope(probe)
+#define PROFILE_START(start)        uint32_t start = Profiler::now()
+#define PROFILE_END(probe, start)   profiler.record(probe, Profiler::now() - (start))
+
+#else
+
+#define PROFILE_SCOPE(probe)
+#define PROFILE_START(start)
+#define PROFILE_END(probe, start)
+
+#endif      // PROFILING
+
+#endif      // __PROFILER_H
@@ -0,0 +1,42 @@
+#ifndef __RESAMPLER_H
+#define __RESAMPLER_H
+
+#include <stdint.h>
+
+#include "def.h"
+#include "chrono.h"
+#include "harmonics.h"
+
+
+// Zero-crossing-synchronous resampler of the analyzed channels: each mains period is
+// interpolated to exactly NB_SAMPLES evenly spaced points, the spacing being the length of
+// the previous period divided by NB_SAMPLES. Points are written straight into the period
+// buffer of the harmonic analysis as the samples arrive, so a period is complete at its
+// closing zero crossing.
+class Resampler
+{
+public:
+    Resampler();
+    ~Resampler() {};
+    void init();
+    void startPeriod(const uint16_t* data, float czPoint);
+    void addSample(const uint16_t* data);
+    void crossZero(const uint16_t* data, float czPoint);
+
+private:
+    void readSample(const uint16_t* data);
+    void emitUntil(float time);
+
+    PeriodBuffer* m_period;
+    float m_prev[NB_FFT_CHANNELS + 1];      // Previous sample of each analyzed channel
+    float m_cur[NB_FFT_CHANNELS + 1];       // Current sample of each analyzed channel
+    float m_prevTime;                       // Time of the previous sample since the period start (timer periods)
+    float m_nextTime;                       // Time of the next output point since the period start (timer periods)
+    float m_step;                           // Spacing of the output points (timer periods)
+    uint16_t m_count;                       // Output points already written in the period
+};
+
+// Chrono object for timing measurements
+extern Chrono resampleChrono;
+
+#endif      // __RESAMPLER_H
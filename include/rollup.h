@@ -0,0 +1,85 @@
+#ifndef __ROLLUP_H
+#define __ROLLUP_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "def.h"
+#include "signals.h"
+#include "currentBank.h"
+#include "jsonWriter.h"
+#include "liveStream.h"
+#include "packetRing.h"
+
+#define ROLLUP_SECONDS_PER_MINUTE   60
+#define ROLLUP_MINUTES_PER_5MIN     5
+#define ROLLUP_5MIN_PER_HOUR        12
+
+
+// Statistics of the periods of a time window, with the compensated accumulators of the packet
+// statistics. merge is associative, so that the window of a tier is built from the windows of
+// the finer tier, never from the periods again.
+struct Aggregate
+{
+    time_t timestamp;                       // End of the window
+    uint32_t nbPeriods;
+    RangeStats<1> tensionRms;
+    RangeStats<1> frequency;
+    PowerStats<NB_CURRENTS> currents;       // Its time is the duration of the window (s)
+
+    void init();
+    void addPeriod(const PeriodFrame &frame);
+    void merge(const Aggregate &other);
+    float getDuration() const {return currents.time.get();}
+};
+
+
+// Rollup of the periods into windows of 1 s, 1 min, 5 min and 1 h, each tier with its own ring.
+// The DSP task adds each period to the open second, and each closed window is merged into the
+// open window of the next tier, so the cost per period does not depend on the number of tiers.
+class Rollup
+{
+public:
+    typedef enum {
+        SECOND = 0,
+        MINUTE,
+        FIVE_MINUTES,
+        HOUR
+    } Resolution;
+
+    Rollup();
+    ~Rollup() {};
+    bool begin();
+    void addPeriod(const PeriodFrame &frame);
+    size_t writeJson(JsonWriter &writer, Resolution resolution, uint32_t since, size_t limit);
+    static bool parseResolution(const char* name, Resolution &resolution);
+    size_t getBytes();
+
+private:
+    template <size_t N>
+    struct Tier {
+        PacketRing<Aggregate, N> ring;
+        Aggregate open;
+        uint16_t nbMerged;                  // Windows of the finer tier merged in the open window
+
+        Tier() : ring(PacketRing<Aggregate, N>::OVERWRITE_OLDEST), nbMerged(0) {open.init();}
+    };
+
+    template <size_t N>
+    static void close(Tier<N> &tier, Aggregate* next);
+    template <size_t N>
+    static size_t writeTier(JsonWriter &writer, Tier<N> &tier, uint32_t since, size_t limit);
+    static void writeJson(JsonWriter &writer, uint32_t seq, const Aggregate &aggregate);
+
+    float m_secondTime;                     // Time elapsed in the open second (s)
+    Tier<ROLLUP_1S_RING_SIZE> m_seconds;
+    Tier<ROLLUP_1M_RING_SIZE> m_minutes;
+    Tier<ROLLUP_5M_RING_SIZE> m_fiveMinutes;
+    Tier<ROLLUP_1H_RING_SIZE> m_hours;
+};
+
+extern Rollup rollup;
+
+#endif      // __ROLLUP_H
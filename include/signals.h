@@ -2,9 +2,12 @@
 #define __SIGNALS_H
 
 #include <stdint.h>
-#include <vector>
 #include <cJSON.h>
 
+#include "def.h"
+#include "jsonWriter.h"
+#include "accumulator.h"
+
 
 struct RangeData {
     float min;
@@ -19,16 +22,19 @@ public:
     Rms();
     ~Rms() {};
     void init();
-    void save(float periodTime, float totalMeasureTime);
-    void update(float val, float deltaT);
-    cJSON* getJson();
-    RangeData getData() {return RangeData(m_min, m_max, m_mean);}
+    void resetStats();
+    void save(float periodTime);
+    void update(float val, float deltaT) {m_temp += val * val * deltaT;}     // Single-precision MAC, inlined in the sample loop
+    cJSON* getJson(float duration);
+    RangeData getData(float duration) {return RangeData(m_min, m_max, m_mean.get(duration));}
+    float getLast() {return m_last;}
 
 private:
-    float m_mean;
+    TimeMean m_mean;
     float m_max;
     float m_min;
     float m_temp;
+    float m_last;           // RMS value of the last complete period
 };
 
 
@@ -38,50 +44,46 @@ public:
     Signal();
     ~Signal() {};
     virtual void init();
+    virtual void resetStats();
     void setChannelId(uint8_t adcChannel);
     void setVal(float val);
+    void setRawVal(const uint16_t* data);
     float getVal() {return m_val;}
+    int32_t getRawVal() {return m_rawVal;}
     virtual cJSON* getJson();
-    static cJSON* serializeData(RangeData &data);
+    static void writeJson(JsonWriter &writer, const char* key, const RangeData &data);
     RangeData getData() {return RangeData({m_minVal, m_maxVal, 0.});}
 
 protected:
     float m_val;
     float m_prevVal;
+    int32_t m_rawVal;       // Raw ADC value (VREF subtracted)
     float m_maxVal;
     float m_minVal;
     Rms m_rms;
-    std::vector<float> m_buffer;
-    uint16_t m_iBuffer;
     uint8_t m_adcChannel;
     float m_calibCoeffA;
     float m_calibCoeffB;
 };
 
 
-class Current : public Signal
+class Current
 {
 public:
     struct Data {
         RangeData rms;
         RangeData range;
+        RangeData activePower;
+        RangeData apparentPower;
+        RangeData reactivePower;
+        RangeData powerFactor;
         float energy;
     };
 
-    Current();
-    ~Current() {};
-    void init() override;
-    void calcSample(float deltaT, bool lastSample);
-    void calcPeriod(float periodTime, float totalMeasureTime) {m_rms.save(periodTime, totalMeasureTime);}
-    cJSON* getJson() override;
-    static cJSON* serializeData(Data &data);
-    Data getData() {return Data({m_rms.getData(), Signal::getData(), m_energy});}
-
-
-private:
-    float m_energy;          // I*U.dt (W.s)
+    static void writeJson(JsonWriter &writer, const char* key, const Data &data);
 };
 
+
 class Tension : public Signal
 {
 public:
@@ -94,15 +96,18 @@ public:
     Tension();
     ~Tension() {};
     void init() override;
+    void resetStats() override;
     bool isCrossingZero(float* czPoint);
     void calcSample(float deltaT, bool lastSample);
-    void calcPeriod(float periodTime, float totalMeasureTime);
+    void calcPeriod(float periodTime);
     cJSON* getJson() override;
-    static cJSON* serializeData(Data &data);
-    Data getData() {return Data({m_rms.getData(), Signal::getData(), RangeData({m_freqMin, m_freqMax, m_freqMean})});}
+    static void writeJson(JsonWriter &writer, const char* key, const Data &data);
+    Data getData() {return Data({m_rms.getData(m_time.get()), Signal::getData(), RangeData({m_freqMin, m_freqMax, m_freqMean.get(m_time.get())})});}
+    float getLastRms() {return m_rms.getLast();}
 
 private:
-    float m_freqMean;
+    KahanSum m_time;        // Duration of the statistics (s)
+    TimeMean m_freqMean;
     float m_freqMax;
     float m_freqMin;
 };
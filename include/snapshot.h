@@ -0,0 +1,49 @@
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+#include "esp_http_server.h"
+#include "jsonWriter.h"
+
+#define SNAPSHOT_SIZE           512         // Bytes of a rendered snapshot
+#define SNAPSHOT_ETAG_SIZE      12          // Quoted 32-bit hash
+#define SNAPSHOT_MATCH_SIZE     64          // Longest If-None-Match header compared
+#define SNAPSHOT_LIVE_PERIOD    1000000     // µs, shortest refresh period of a source without a version counter (heap)
+
+
+// Pre-rendered JSON response of a read-mostly endpoint. The data source publishes a version
+// number, which changes whenever its values may have changed (a counter, or a time bucket for
+// live values); the snapshot is rendered again only when a request sees a new version, into a
+// fixed buffer. Its ETag is a hash of the rendered bytes, so a request with a matching
+// If-None-Match gets a 304 as long as the content is the same. No allocation per request.
+class Snapshot
+{
+public:
+    typedef uint32_t (*VersionFunction)(void* ctx);
+    typedef void (*RenderFunction)(JsonWriter &writer, void* ctx);
+
+    Snapshot(VersionFunction version, RenderFunction render, void* ctx = nullptr);
+    ~Snapshot() {};
+
+    esp_err_t serve(httpd_req_t *req);
+
+private:
+    void update();
+    static bool append(void* ctx, const char* data, size_t size);
+
+    VersionFunction m_version;
+    RenderFunction m_render;
+    void* m_ctx;
+
+    std::mutex m_mutex;
+    char m_data[SNAPSHOT_SIZE];
+    size_t m_size;
+    bool m_valid;                           // Rendered from m_renderVersion, and it fitted in the buffer
+    uint32_t m_renderVersion;
+    char m_etag[SNAPSHOT_ETAG_SIZE];
+};
+
+#endif      // __SNAPSHOT_H
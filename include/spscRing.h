@@ -0,0 +1,97 @@
+#ifndef __SPSCRING_H
+#define __SPSCRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+
+// Bounded lock-free ring for one producer and one consumer.
+// Items are written and read in place: the producer reserves a slot, fills it
+// and commits it, the consumer reads the front slot and releases it.
+template <typename T, size_t N>
+class SpscRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() {};
+    ~SpscRing() {};
+
+    // Producer side: returns nullptr (and counts an overrun) if the ring is full
+    T* reserve()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == N) {
+            m_nbOverrun.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &m_items[head & (N - 1)];
+    }
+
+    void commit()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed) + 1;
+        m_head.store(head, std::memory_order_release);
+        m_nbPushed.fetch_add(1, std::memory_order_relaxed);
+
+        size_t used = head - m_tail.load(std::memory_order_relaxed);
+        if (used > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(used, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T &item)
+    {
+        T* slot = reserve();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // Consumer side: returns nullptr if the ring is empty
+    T* front()
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_items[tail & (N - 1)];
+    }
+
+    void release()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool pop(T &item)
+    {
+        T* slot = front();
+        if (slot == nullptr) {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // Statistics, readable from any task
+    size_t capacity() const {return N;}
+    size_t size() const {return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);}
+    size_t getHighWater() const {return m_highWater.load(std::memory_order_relaxed);}
+    uint32_t getNbPushed() const {return m_nbPushed.load(std::memory_order_relaxed);}
+    uint32_t getNbOverrun() const {return m_nbOverrun.load(std::memory_order_relaxed);}
+
+private:
+    T m_items[N];
+    std::atomic<size_t> m_head = 0;
+    std::atomic<size_t> m_tail = 0;
+    std::atomic<size_t> m_highWater = 0;
+    std::atomic<uint32_t> m_nbPushed = 0;
+    std::atomic<uint32_t> m_nbOverrun = 0;
+};
+
+#endif      // __SPSCRING_H
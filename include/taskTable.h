@@ -0,0 +1,43 @@
+#ifndef __TASKTABLE_H
+#define __TASKTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "def.h"
+
+typedef enum {
+    LOG_TASK = 0,
+    STREAM_TASK,
+    HARMONIC_TASK,
+    DSP_TASK,
+    ADC_TASK,
+    HTTP_TASK,
+    HTTP_WORKER_0_TASK,
+    HTTP_WORKER_1_TASK,
+    WIFI_TASK,
+    TCPIP_TASK,
+    NB_TASKS
+} TaskId;
+
+// Placement of a pipeline stage. The tasks without function are created by their IDF
+// component: the HTTP server takes its placement from the table, the others from sdkconfig.
+typedef struct {
+    const char* name;
+    TaskFunction_t function;
+    TaskHandle_t* handle;
+    uint32_t stackSize;                 // bytes
+    UBaseType_t priority;
+    BaseType_t core;
+    const char* input;                  // Queue from the previous stage (notification-driven)
+    uint16_t inputDepth;                // items
+} TaskPlacement;
+
+bool tasks_start();
+const TaskPlacement& tasks_get(TaskId id);
+TaskHandle_t tasks_getHandle(TaskId id);
+
+#endif      // __TASKTABLE_H
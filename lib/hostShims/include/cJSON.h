@@ -0,0 +1,24 @@
+#ifndef __CJSON_SHIM_H
+#define __CJSON_SHIM_H
+
+// Host build: the subset of cJSON used by the DSP sources, objects of numbers and objects
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* child;
+    char* string;
+    double valuedouble;
+    int type;
+} cJSON;
+
+#define cJSON_Number    (1 << 3)
+#define cJSON_Object    (1 << 6)
+
+cJSON* cJSON_CreateObject();
+cJSON* cJSON_CreateNumber(double num);
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number);
+int cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item);
+char* cJSON_PrintUnformatted(const cJSON* item);
+void cJSON_Delete(cJSON* item);
+void cJSON_free(void* object);
+
+#endif      // __CJSON_SHIM_H
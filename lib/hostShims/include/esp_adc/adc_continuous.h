@@ -0,0 +1,8 @@
+#ifndef __ADC_CONTINUOUS_SHIM_H
+#define __ADC_CONTINUOUS_SHIM_H
+
+// Host build: only the record type, the driver itself is replaced by AdcSimulator
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+#endif      // __ADC_CONTINUOUS_SHIM_H
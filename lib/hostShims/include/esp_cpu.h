@@ -0,0 +1,11 @@
+#ifndef __ESP_CPU_SHIM_H
+#define __ESP_CPU_SHIM_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+// Host build: steady clock scaled to CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count();
+
+#endif      // __ESP_CPU_SHIM_H
@@ -0,0 +1,17 @@
+#ifndef __ESP_HEAP_CAPS_SHIM_H
+#define __ESP_HEAP_CAPS_SHIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+// Host build: like the devkit without PSRAM, a MALLOC_CAP_SPIRAM allocation fails
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+
+#endif      // __ESP_HEAP_CAPS_SHIM_H
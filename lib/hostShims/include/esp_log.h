@@ -0,0 +1,12 @@
+#ifndef __ESP_LOG_SHIM_H
+#define __ESP_LOG_SHIM_H
+
+#include <stdio.h>
+
+// Host build: warnings and errors on stderr, the info and debug levels are dropped
+#define ESP_LOGE(tag, format, ...)  fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  do {(void)(tag);} while (0)
+#define ESP_LOGD(tag, format, ...)  do {(void)(tag);} while (0)
+
+#endif      // __ESP_LOG_SHIM_H
@@ -0,0 +1,9 @@
+#ifndef __ESP_ROM_CRC_SHIM_H
+#define __ESP_ROM_CRC_SHIM_H
+
+#include <stdint.h>
+
+// CRC32 of the ROM (IEEE 802.3, reflected), chained through crc
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif      // __ESP_ROM_CRC_SHIM_H
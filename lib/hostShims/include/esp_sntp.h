@@ -0,0 +1,20 @@
+#ifndef __ESP_SNTP_SHIM_H
+#define __ESP_SNTP_SHIM_H
+
+#include <stdint.h>
+
+#define ESP_SNTP_OPMODE_POLL    0
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+
+// Host build: the system clock of the host is already synchronized
+void esp_sntp_setoperatingmode(uint8_t operating_mode);
+void esp_sntp_setservername(uint8_t idx, const char* server);
+void esp_sntp_init();
+sntp_sync_status_t sntp_get_sync_status();
+
+#endif      // __ESP_SNTP_SHIM_H
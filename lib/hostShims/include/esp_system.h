@@ -0,0 +1,11 @@
+#ifndef __ESP_SYSTEM_SHIM_H
+#define __ESP_SYSTEM_SHIM_H
+
+#include "esp_err.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+// Host build: the handlers are registered, but there is no esp_restart to call them
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+
+#endif      // __ESP_SYSTEM_SHIM_H
@@ -0,0 +1,11 @@
+#ifndef __ESP_TIMER_SHIM_H
+#define __ESP_TIMER_SHIM_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Microseconds since the first call (steady clock of the host)
+int64_t esp_timer_get_time();
+
+#endif      // __ESP_TIMER_SHIM_H
@@ -0,0 +1,24 @@
+#ifndef __FREERTOS_SHIM_H
+#define __FREERTOS_SHIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ      100
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+#define IRAM_ATTR
+
+// Host build: the tests run in plain threads, never in an interrupt
+static inline BaseType_t xPortInIsrContext() {return pdFALSE;}
+
+#endif      // __FREERTOS_SHIM_H
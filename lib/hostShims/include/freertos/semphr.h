@@ -0,0 +1,9 @@
+#ifndef __FREERTOS_SEMPHR_SHIM_H
+#define __FREERTOS_SEMPHR_SHIM_H
+
+#include "FreeRTOS.h"
+
+// Host build: only the handle type, for the declarations of adc.h
+typedef void* SemaphoreHandle_t;
+
+#endif      // __FREERTOS_SEMPHR_SHIM_H
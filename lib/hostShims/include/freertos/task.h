@@ -0,0 +1,14 @@
+#ifndef __FREERTOS_TASK_SHIM_H
+#define __FREERTOS_TASK_SHIM_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+// Host build: no scheduler, the tests call the task bodies (Harmonics::process...) themselves.
+// A notification is dropped, and a wait returns at once without any.
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskDelay(TickType_t xTicksToDelay);
+
+#endif      // __FREERTOS_TASK_SHIM_H
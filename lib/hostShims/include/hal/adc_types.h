@@ -0,0 +1,27 @@
+#ifndef __ADC_TYPES_SHIM_H
+#define __ADC_TYPES_SHIM_H
+
+#include <stdint.h>
+
+#include "soc/soc_caps.h"
+
+typedef enum {
+    ADC_UNIT_1,
+    ADC_UNIT_2
+} adc_unit_t;
+
+// DMA record of the ESP32-S3 (TYPE2 output format), same layout as ESP-IDF
+typedef struct {
+    union {
+        struct {
+            uint32_t data:          12;
+            uint32_t reserved12:    1;
+            uint32_t channel:       4;
+            uint32_t unit:          1;
+            uint32_t reserved17_31: 14;
+        } type2;
+        uint32_t val;
+    };
+} adc_digi_output_data_t;
+
+#endif      // __ADC_TYPES_SHIM_H
@@ -0,0 +1,7 @@
+#ifndef __LWIP_SOCKETS_SHIM_H
+#define __LWIP_SOCKETS_SHIM_H
+
+// Host build: the BSD sockets of the host
+#include <sys/socket.h>
+
+#endif      // __LWIP_SOCKETS_SHIM_H
@@ -0,0 +1,9 @@
+#ifndef __NVS_FLASH_SHIM_H
+#define __NVS_FLASH_SHIM_H
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init();
+esp_err_t nvs_flash_erase();
+
+#endif      // __NVS_FLASH_SHIM_H
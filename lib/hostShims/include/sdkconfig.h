@@ -0,0 +1,8 @@
+#ifndef __SDKCONFIG_SHIM_H
+#define __SDKCONFIG_SHIM_H
+
+// Host build: the options of sdkconfig.esp32-s3-devkitc-1 read by the native sources.
+// CONFIG_METER_PROFILING is left unset, so the benchmarks time the DSP without the probes.
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ     160
+
+#endif      // __SDKCONFIG_SHIM_H
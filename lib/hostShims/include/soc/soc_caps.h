@@ -0,0 +1,8 @@
+#ifndef __SOC_CAPS_SHIM_H
+#define __SOC_CAPS_SHIM_H
+
+// ESP32-S3 values
+#define SOC_ADC_DIGI_DATA_BYTES_PER_CONV    4
+#define SOC_ADC_DIGI_MAX_BITWIDTH           12
+
+#endif      // __SOC_CAPS_SHIM_H
@@ -0,0 +1,112 @@
+#include <cJSON.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+
+cJSON* cJSON_CreateObject()
+{
+    cJSON* item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    if (item != nullptr) {
+        item->type = cJSON_Object;
+    }
+    return item;
+}
+
+cJSON* cJSON_CreateNumber(double num)
+{
+    cJSON* item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    if (item != nullptr) {
+        item->type = cJSON_Number;
+        item->valuedouble = num;
+    }
+    return item;
+}
+
+int cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item)
+{
+    if (object == nullptr || string == nullptr || item == nullptr) {
+        return 0;
+    }
+    item->string = strdup(string);
+
+    cJSON** last = &object->child;
+    while (*last != nullptr) {
+        last = &(*last)->next;
+    }
+    *last = item;
+    return 1;
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number)
+{
+    cJSON* item = cJSON_CreateNumber(number);
+    if (!cJSON_AddItemToObject(object, name, item)) {
+        cJSON_Delete(item);
+        return nullptr;
+    }
+    return item;
+}
+
+static void print(const cJSON* item, std::string &out)
+{
+    if (item->type == cJSON_Number) {
+        char number[32];
+        double val = item->valuedouble;
+        if (isnan(val) || isinf(val)) {
+            snprintf(number, sizeof(number), "null");
+        }
+        else if (val == (double)(int)val) {
+            snprintf(number, sizeof(number), "%d", (int)val);
+        }
+        else {
+            snprintf(number, sizeof(number), "%1.15g", val);
+            if (strtod(number, nullptr) != val) {
+                snprintf(number, sizeof(number), "%1.17g", val);
+            }
+        }
+        out += number;
+        return;
+    }
+
+    out += '{';
+    for (const cJSON* child = item->child; child != nullptr; child = child->next) {
+        out += '"';
+        out += child->string;
+        out += "\":";
+        print(child, out);
+        if (child->next != nullptr) {
+            out += ',';
+        }
+    }
+    out += '}';
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item)
+{
+    if (item == nullptr) {
+        return nullptr;
+    }
+    std::string out;
+    print(item, out);
+    return strdup(out.c_str());
+}
+
+void cJSON_Delete(cJSON* item)
+{
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void* object)
+{
+    free(object);
+}
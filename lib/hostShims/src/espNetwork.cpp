@@ -0,0 +1,36 @@
+#include <esp_http_server.h>
+#include <esp_sntp.h>
+
+void esp_sntp_setoperatingmode(uint8_t operating_mode)
+{}
+
+void esp_sntp_setservername(uint8_t idx, const char* server)
+{}
+
+void esp_sntp_init()
+{}
+
+sntp_sync_status_t sntp_get_sync_status()
+{
+    return SNTP_SYNC_STATUS_COMPLETED;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void* arg)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t* frame)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    return ESP_FAIL;
+}
@@ -0,0 +1,102 @@
+#include <esp_partition.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Blobs of the RAM NVS by namespace, then key. A handle is the index of its namespace + 1.
+static std::vector<std::string> nvsNamespaces;
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvsBlobs;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label)
+{
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size)
+{
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size)
+{
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t nvs_flash_init()
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase()
+{
+    nvsBlobs.clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    // As on the target, a namespace only exists once something was written in it
+    if (open_mode == NVS_READONLY && nvsBlobs.count(name) == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (size_t i = 0; i < nvsNamespaces.size(); i++) {
+        if (nvsNamespaces[i] == name) {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    nvsNamespaces.push_back(name);
+    *out_handle = nvsNamespaces.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    if (handle == 0 || handle > nvsNamespaces.size()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto blobs = nvsBlobs.find(nvsNamespaces[handle - 1]);
+    if (blobs == nvsBlobs.end() || blobs->second.count(key) == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    const std::vector<uint8_t> &blob = blobs->second[key];
+    if (out_value == nullptr) {
+        *length = blob.size();
+        return ESP_OK;
+    }
+    if (*length < blob.size()) {
+        *length = blob.size();
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, blob.data(), blob.size());
+    *length = blob.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    if (handle == 0 || handle > nvsNamespaces.size()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    nvsBlobs[nvsNamespaces[handle - 1]][key].assign(bytes, bytes + length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
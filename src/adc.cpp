@@ -1,16 +1,17 @@
 #include "adc.h"
+#include "adcSimulator.h"
+#include "measure.h"
+#include "profiler.h"
+#include "deadlineMonitor.h"
 
 // Mutex for synchronizing access to shared resources
 SemaphoreHandle_t mutex = nullptr;
 
-// Array to store ADC values for each channel
-volatile int adcValues[NB_CHANNELS] = {0};
+// Handle of the DSP task, notified each time a block is pushed into the ring
+TaskHandle_t dspTaskHandle = nullptr;
 
 // Array of ADC channels to be sampled
-static const adc_channel_t ADC_CHANNELS[NB_CHANNELS] = {
-    ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3,
-    ADC_CHANNEL_4, ADC_CHANNEL_5, ADC_CHANNEL_6
-};
+static const uint8_t* ADC_CHANNELS = ActiveLayout::adcChannels;
 
 // Flag to indicate if an action is required
 static volatile bool actionFlag = false;
@@ -18,12 +19,92 @@ static volatile bool actionFlag = false;
 // Pointer to the raw ADC data buffer
 static uint8_t *adc_raw;
 
+// Demultiplexer of the DMA frames and ring of the resulting per-channel blocks
+AdcDemux adcDemux(ADC_CHANNELS);
+SpscRing<AdcBlock, ADC_RING_SIZE> adcRing;
+
+// Chronos to measure the acquisition and the processing time of a DMA frame
+Chrono adcChrono("ADC", ADC_BLOCK_PERIOD, SAMPLE_RATE / ADC_BLOCK_SIZE, DEBUG);
+Chrono dspChrono("DSP", ADC_BLOCK_PERIOD, SAMPLE_RATE / ADC_BLOCK_SIZE, DEBUG);
+
+/**
+ * @brief Demultiplex a DMA frame into the block ring.
+ *
+ * The DSP task is notified when a block is pushed. A frame read while the ring
+ * is full is dropped and counted as an overrun by the ring.
+ *
+ * @param size Size of the frame in bytes.
+ */
+static void push_frame(uint32_t size) {
+    adcChrono.startCycle();
+    AdcBlock* block = adcRing.reserve();
+    if (block != nullptr) {
+        PROFILE_START(demuxStart);
+        uint16_t nbSamples = adcDemux.parse(adc_raw, size, *block);
+        PROFILE_END(PROFILE_DEMUX, demuxStart);
+        if (nbSamples > 0) {
+            adcRing.commit();
+            xTaskNotifyGive(dspTaskHandle);
+        }
+    }
+    adcChrono.endCycle();
+}
+
+#if ADC_SIMULATION
+/**
+ * @brief Simulated conversion clock callback function.
+ *
+ * This function is called by a periodic esp_timer every ADC_BLOCK_PERIOD µs, in
+ * place of the conversion done callback: the frame is timestamped and the ADC
+ * task is notified. The FreeRTOS tick is too coarse to pace the frames.
+ *
+ * @param arg Pointer to the argument (task handle in this case).
+ */
+static void sim_frame_cb(void *arg) {
+    deadlineMonitor.frameDone();
+    xTaskNotifyGive(static_cast<TaskHandle_t>(arg));
+}
+
+/**
+ * @brief Simulated ADC task function.
+ *
+ * This function replaces the ADC by synthetic frames pushed at the block period,
+ * so that the whole DSP path can be benchmarked without any signal wired.
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void adc_task(void *pvParameters) {
+    adc_raw = static_cast<uint8_t*>(heap_caps_malloc(ADC_FRAME_SIZE, MALLOC_CAP_DEFAULT));
+    assert(adc_raw != NULL);
+
+    AdcSimulator simulator(ADC_CHANNELS);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = sim_frame_cb,
+        .arg = xTaskGetCurrentTaskHandle(),
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "adc_sim",
+        .skip_unhandled_events = false
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, (uint64_t)ADC_BLOCK_PERIOD));
+
+    while(1) {
+        // One frame per tick of the simulated conversion clock
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+        PROFILE_START(readStart);
+        uint32_t size = simulator.fill(adc_raw, ADC_FRAME_SIZE);
+        PROFILE_END(PROFILE_ACQUISITION, readStart);
+        deadlineMonitor.frameRead(size);
+        push_frame(size);
+    }
+}
+#else
 // Handle for the ADC continuous mode
 static adc_continuous_handle_t adc_handle = NULL;
 
-// Chrono to measure ADC convertion time
-Chrono adcChrono("ADC", 100, SAMPLE_RATE, DEBUG);
-
 /**
  * @brief ADC conversion done callback function.
  *
@@ -37,51 +118,40 @@ Chrono adcChrono("ADC", 100, SAMPLE_RATE, DEBUG);
  */
 static bool IRAM_ATTR adc_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
     BaseType_t high_task_awoken = pdFALSE;
+    deadlineMonitor.frameDone();
     vTaskNotifyGiveFromISR(static_cast<TaskHandle_t>(user_data), &high_task_awoken);
     return high_task_awoken == pdTRUE;
 }
 
 /**
- * @brief ADC timer callback function.
+ * @brief ADC pool overflow callback function.
  *
- * This function is called periodically by the timer. It reads the ADC values,
- * processes them, and updates the shared resources.
+ * This function is called when a complete frame does not fit in the driver pool:
+ * its conversions are lost. It is counted by the deadline monitor.
  *
- * @param arg Pointer to the argument passed to the timer callback.
+ * @param handle ADC continuous handle.
+ * @param edata Pointer to the ADC continuous event data.
+ * @param user_data Pointer to the user data (task handle in this case).
+ * @return False, no task is woken.
  */
-static void adc_timer_callback(void* arg) {
-    adcChrono.startCycle();
-    BaseType_t high_task_awoken = pdFALSE;
-
-    for (int i = 0; i < NB_CHANNELS; i++) {
-        xSemaphoreTakeFromISR(mutex, &high_task_awoken);
-        uint32_t adc_reading = ((uint32_t*)adc_raw)[i];
-        adcValues[i] = adc_reading & 0xFFF;
-        xSemaphoreGiveFromISR(mutex, &high_task_awoken);
-    }
-
-    if (high_task_awoken) {
-        portYIELD_FROM_ISR();
-    }
-
-    adcChrono.endCycle();
+static bool IRAM_ATTR adc_pool_ovf_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+    deadlineMonitor.frameDropped();
+    return false;
 }
 
 /**
  * @brief ADC task function.
  *
  * This function initializes the ADC, configures it, and starts the ADC continuous
- * mode. It then waits for notifications from the ADC conversion done callback
- * and processes the ADC data.
+ * mode. It then waits for notifications from the ADC conversion done callback,
+ * demultiplexes every conversion of the DMA frames into the block ring.
  *
  * @param pvParameters Pointer to the task parameters (not used in this case).
  */
 void adc_task(void *pvParameters) {
-    esp_err_t ret;
-
     adc_continuous_handle_cfg_t adc_config = {
         .max_store_buf_size = DMA_BUFFER_SIZE,
-        .conv_frame_size = SOC_ADC_DIGI_DATA_BYTES_PER_CONV * NB_CHANNELS,
+        .conv_frame_size = ADC_FRAME_SIZE,
     };
     ESP_ERROR_CHECK(adc_continuous_new_handle(&adc_config, &adc_handle));
 
@@ -93,7 +163,7 @@ void adc_task(void *pvParameters) {
     adc_digi_pattern_config_t adc_pattern[NB_CHANNELS];
     for (int i = 0; i < NB_CHANNELS; i++) {
         adc_pattern[i].atten = ADC_ATTEN_DB_11;
-        adc_pattern[i].channel = ADC_CHANNELS[i] & 0x7;
+        adc_pattern[i].channel = ADC_CHANNELS[i];
         adc_pattern[i].unit = ADC_UNIT_1;
         adc_pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
     }
@@ -101,33 +171,53 @@ void adc_task(void *pvParameters) {
     dig_cfg.adc_pattern = adc_pattern;
     ESP_ERROR_CHECK(adc_continuous_config(adc_handle, &dig_cfg));
 
-    adc_raw = static_cast<uint8_t*>(heap_caps_malloc(DMA_BUFFER_SIZE, MALLOC_CAP_DMA));
+    adc_raw = static_cast<uint8_t*>(heap_caps_malloc(ADC_FRAME_SIZE, MALLOC_CAP_DMA));
     assert(adc_raw != NULL);
 
     adc_continuous_evt_cbs_t cbs;
     cbs.on_conv_done = adc_conv_done_cb;
+    cbs.on_pool_ovf = adc_pool_ovf_cb;
 
     ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc_handle, &cbs, xTaskGetCurrentTaskHandle()));
 
     ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
 
-    esp_timer_create_args_t timer_args;
-    timer_args.callback = &adc_timer_callback;
-    timer_args.name = "adc_timer";
-
-    esp_timer_handle_t timer;
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, 1000000 / SAMPLE_RATE));
-
     while(1) {
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
+        // Drain every frame available since the last notification
         uint32_t ret_num = 0;
-        ret = adc_continuous_read(adc_handle, adc_raw, DMA_BUFFER_SIZE, &ret_num, 0);
-        if (ret == ESP_OK) {
-            // Process data here if needed
+        while (1) {
+            PROFILE_START(readStart);
+            if (adc_continuous_read(adc_handle, adc_raw, ADC_FRAME_SIZE, &ret_num, 0) != ESP_OK) {
+                break;
+            }
+            PROFILE_END(PROFILE_ACQUISITION, readStart);
+            deadlineMonitor.frameRead(ret_num);
+            push_frame(ret_num);
         }
+    }
+}
+#endif
 
-        vTaskDelay(1);
+/**
+ * @brief DSP task function.
+ *
+ * This function waits for notifications from the ADC task and drains the block
+ * ring into the measure.
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void dsp_task(void *pvParameters) {
+    while(1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        AdcBlock* block;
+        while ((block = adcRing.front()) != nullptr) {
+            dspChrono.startCycle();
+            measure.adcBlockCallback(*block);
+            adcRing.release();
+            dspChrono.endCycle();
+        }
     }
 }
@@ -0,0 +1,73 @@
+#include "adcDemux.h"
+
+#include <hal/adc_types.h>
+
+
+/**
+ * @brief Constructor for the AdcDemux class.
+ *
+ * Builds the reverse lookup table used to route each conversion record to its
+ * logical channel.
+ *
+ * @param adcChannels Hardware ADC channel of each logical channel (NB_CHANNELS entries).
+ */
+AdcDemux::AdcDemux(const uint8_t* adcChannels) :
+    m_nbInvalid(0),
+    m_nbDiscarded(0)
+{
+    for (uint8_t i = 0; i < ADC_HW_CHANNELS; i++) {
+        m_channelMap[i] = -1;
+    }
+    for (uint8_t i = 0; i < NB_CHANNELS; i++) {
+        m_channelMap[adcChannels[i] & (ADC_HW_CHANNELS - 1)] = i;
+    }
+}
+
+/**
+ * @brief Parse a DMA frame into per-channel sample blocks.
+ *
+ * Every TYPE2 record of the frame is routed to the block of its channel. Records
+ * from another unit or an unsampled channel are counted as invalid, and samples
+ * belonging to an incomplete conversion set at the end of the frame are discarded
+ * so that all the channels of the block stay in phase.
+ *
+ * @param frame Raw DMA frame returned by adc_continuous_read.
+ * @param size Size of the frame in bytes.
+ * @param block Block to fill.
+ * @return uint16_t Number of complete conversion sets in the block.
+ */
+uint16_t AdcDemux::parse(const uint8_t* frame, uint32_t size, AdcBlock &block)
+{
+    for (uint8_t i = 0; i < NB_CHANNELS; i++) {
+        m_count[i] = 0;
+    }
+
+    const adc_digi_output_data_t* records = reinterpret_cast<const adc_digi_output_data_t*>(frame);
+    uint32_t nbRecords = size / sizeof(adc_digi_output_data_t);
+
+    for (uint32_t i = 0; i < nbRecords; i++) {
+        const adc_digi_output_data_t &record = records[i];
+        int8_t channel = m_channelMap[record.type2.channel];
+
+        if (record.type2.unit != ADC_UNIT_1 || channel < 0 || m_count[channel] == ADC_BLOCK_SIZE) {
+            m_nbInvalid++;
+            continue;
+        }
+
+        block.samples[channel][m_count[channel]] = record.type2.data;
+        m_count[channel]++;
+    }
+
+    uint16_t nbSamples = ADC_BLOCK_SIZE;
+    for (uint8_t i = 0; i < NB_CHANNELS; i++) {
+        if (m_count[i] < nbSamples) {
+            nbSamples = m_count[i];
+        }
+    }
+    for (uint8_t i = 0; i < NB_CHANNELS; i++) {
+        m_nbDiscarded += m_count[i] - nbSamples;
+    }
+
+    block.nbSamples = nbSamples;
+    return nbSamples;
+}
@@ -0,0 +1,97 @@
+#include "adcSimulator.h"
+
+#include <math.h>
+#include <hal/adc_types.h>
+
+#define SIM_NB_HARMONICS 3
+
+// Relative amplitude of the fundamental, 3rd and 5th harmonics
+static const uint8_t SIM_HARMONIC_RANKS[SIM_NB_HARMONICS] = {1, 3, 5};
+static const float SIM_HARMONIC_AMPLITUDES[SIM_NB_HARMONICS] = {1., 0.05, 0.03};
+
+
+/**
+ * @brief Constructor for the AdcSimulator class.
+ *
+ * @param adcChannels Hardware ADC channel of each logical channel (NB_CHANNELS entries).
+ */
+AdcSimulator::AdcSimulator(const uint8_t* adcChannels) :
+    m_adcChannels(adcChannels),
+    m_phase(0.f)
+{
+    setFrequency(SIM_AC_FREQ);
+}
+
+/**
+ * @brief Set the frequency of the simulated mains.
+ *
+ * @param freq Frequency in Hz.
+ */
+void AdcSimulator::setFrequency(float freq)
+{
+    m_phaseStep = 2.f * (float)M_PI * freq * (float)TIM_PERIOD / 1000000.f;
+}
+
+/**
+ * @brief Compute the raw sample of a channel at the current phase.
+ *
+ * @param channel Logical channel.
+ * @return uint16_t Raw 12-bit ADC value.
+ */
+uint16_t AdcSimulator::sample(uint8_t channel)
+{
+    if (channel == VREF_ID) {
+        return SIM_VREF;
+    }
+
+    // Currents get a decreasing amplitude and an increasing phase lag
+    float amplitude = SIM_TENSION_AMPLITUDE;
+    float phase = 0.f;
+    if (channel < NB_CURRENTS) {
+        amplitude = SIM_CURRENT_AMPLITUDE / (channel + 1);
+        phase = SIM_CURRENT_PHASE_STEP * channel;
+    }
+
+    float val = SIM_VREF;
+    for (uint8_t i = 0; i < SIM_NB_HARMONICS; i++) {
+        val += amplitude * SIM_HARMONIC_AMPLITUDES[i] * sinf(SIM_HARMONIC_RANKS[i] * (m_phase + phase));
+    }
+
+    if (val < 0.f) {
+        return 0;
+    }
+    if (val > 4095.f) {
+        return 4095;
+    }
+    return (uint16_t)val;
+}
+
+/**
+ * @brief Fill a DMA frame with complete conversion sets.
+ *
+ * @param frame Frame to fill.
+ * @param size Size of the frame in bytes.
+ * @return uint32_t Number of bytes written.
+ */
+uint32_t AdcSimulator::fill(uint8_t* frame, uint32_t size)
+{
+    adc_digi_output_data_t* records = reinterpret_cast<adc_digi_output_data_t*>(frame);
+    uint32_t nbSets = size / (sizeof(adc_digi_output_data_t) * NB_CHANNELS);
+
+    for (uint32_t i = 0; i < nbSets; i++) {
+        for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+            adc_digi_output_data_t &record = records[i * NB_CHANNELS + j];
+            record.val = 0;
+            record.type2.data = sample(j);
+            record.type2.channel = m_adcChannels[j];
+            record.type2.unit = ADC_UNIT_1;
+        }
+
+        m_phase += m_phaseStep;
+        if (m_phase > 2.f * (float)M_PI) {
+            m_phase -= 2.f * (float)M_PI;
+        }
+    }
+
+    return nbSets * NB_CHANNELS * sizeof(adc_digi_output_data_t);
+}
@@ -3,6 +3,7 @@
 
 #include <esp_log.h>
 #include <esp_timer.h>
+#include <stdio.h>
 
 
 /**
@@ -17,8 +18,7 @@ Chrono::Chrono(std::string name, int limit, int printFreq, bool debug) :
     m_name("Chrono" + name),
     m_limit(limit),
     m_debug(debug),
-    m_printFreq(printFreq),
-    m_nbOverLimit(0)
+    m_printFreq(printFreq)
 {
     init();
 }
@@ -38,6 +38,7 @@ void Chrono::init()
     m_maxTime = 0;
     m_minTime = 1000000;
     m_meanTime = 0;
+    m_nbOverLimit = 0;
 }
 
 /**
@@ -84,18 +85,43 @@ void Chrono::endCycle()
 /**
  * @brief Calcul the global timing statistics (for API GET)
  *
- * Logs the global minimum, maximum, and mean times of the cycles.
+ * Merges the statistics of the last printFreq cycles into the global ones, under the
+ * sequence lock read by readTotals.
  */
 void Chrono::calcGlobal()
 {
-    if (m_maxTime > m_totalMaxTime) {
-        m_totalMaxTime = m_maxTime;
+    uint32_t version = m_version.load(std::memory_order_relaxed);
+    m_version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (m_maxTime > m_totals.maxTime) {
+        m_totals.maxTime = m_maxTime;
     }
-    if (m_minTime < m_totalMinTime) {
-        m_totalMinTime = m_minTime;
+    if (m_minTime < m_totals.minTime) {
+        m_totals.minTime = m_minTime;
     }
-    m_totalMeanTime = (m_totalMeanTime * m_totalIter + m_meanTime) / (m_totalIter + 1);
-    m_totalIter++;
+    m_totals.meanTime = (m_totals.meanTime * m_totals.iter + m_meanTime) / (m_totals.iter + 1);
+    m_totals.nbOverLimit += m_nbOverLimit;
+    m_totals.iter++;
+
+    m_version.store(version + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Copy the global statistics, all from the same merge, without blocking the timed task
+ *
+ * @param totals Output
+ */
+void Chrono::readTotals(Chrono::Totals &totals)
+{
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = m_version.load(std::memory_order_acquire);
+        totals = m_totals;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_version.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
 }
 
 /**
@@ -109,24 +135,22 @@ void Chrono::print()
 }
 
 /**
- * @brief get the global chrono statistics
+ * @brief Write the global chrono statistics
  * 
- * @return std::string json global statistics
+ * @param writer JSON writer, inside an object
  */
-std::string Chrono::getGlobalStats()
+void Chrono::writeGlobalStats(JsonWriter &writer)
 {
-
-    cJSON *json = cJSON_CreateObject();
-
-    cJSON_AddStringToObject(json, "Chrono", m_name.c_str());
-    cJSON_AddNumberToObject(json, "ElapsedTime(s)", m_totalIter);
-    cJSON_AddNumberToObject(json, "min(µs)", m_totalMinTime);
-    cJSON_AddNumberToObject(json, "mean(µs)", m_totalMeanTime);
-    cJSON_AddNumberToObject(json, "max(µs)", m_totalMaxTime);
-    cJSON_AddNumberToObject(json, std::string("nbOver" + std::to_string(m_limit) +"µs(%)").c_str(), (float)m_nbOverLimit / (m_totalIter * m_printFreq) * 100);
-
-    std::string globalStats = cJSON_Print(json);
-    cJSON_Delete(json); 
-
-    return globalStats;
+    Totals totals;
+    readTotals(totals);
+
+    char overLimitKey[32];
+    snprintf(overLimitKey, sizeof(overLimitKey), "nbOver%iµs(%%)", m_limit);
+
+    writer.addString("Chrono", m_name.c_str());
+    writer.addNumber("ElapsedTime(s)", totals.iter);
+    writer.addNumber("min(µs)", totals.minTime);
+    writer.addNumber("mean(µs)", totals.meanTime);
+    writer.addNumber("max(µs)", totals.maxTime);
+    writer.addNumber(overLimitKey, (float)totals.nbOverLimit / (totals.iter * m_printFreq) * 100);
 }
@@ -0,0 +1,152 @@
+#include "deadlineMonitor.h"
+#include "adc.h"
+#include "errorManager.h"
+
+#include <math.h>
+#include <esp_timer.h>
+
+DeadlineMonitor deadlineMonitor;
+
+// Upper bounds of the jitter bins (µs), the last bin has none
+static const uint32_t jitterBounds[DEADLINE_JITTER_BINS - 1] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+
+DeadlineMonitor::DeadlineMonitor() :
+    m_nbFrames(0),
+    m_nbDropped(0),
+    m_nextFrame(0),
+    m_readBytes(0),
+    m_firstTime(0),
+    m_prevTime(0),
+    m_nbPeriods(0),
+    m_nbMissed(0),
+    m_nbLate(0),
+    m_nbJitterOver(0),
+    m_nbUnmonitored(0),
+    m_maxLatency(0),
+    m_maxJitter(0),
+    m_samplePeriod(TIM_PERIOD)
+{
+    for (std::atomic<uint32_t> &bin : m_jitterBins) {
+        bin.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t DeadlineMonitor::getJitterBound(uint8_t bin)
+{
+    return (bin < DEADLINE_JITTER_BINS - 1) ? jitterBounds[bin] : UINT32_MAX;
+}
+
+/**
+ * @brief Timestamp a complete DMA frame (conversion-done ISR, integer only)
+ */
+void IRAM_ATTR DeadlineMonitor::frameDone()
+{
+    uint32_t seq = m_nbFrames.load(std::memory_order_relaxed);
+    Frame &frame = m_frames[seq % DEADLINE_RING_SIZE];
+    frame.time = esp_timer_get_time();
+    frame.dropped = false;
+    m_nbFrames.store(seq + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Mark the last complete frame as dropped (pool overflow ISR, raised after the conversion-done one)
+ */
+void IRAM_ATTR DeadlineMonitor::frameDropped()
+{
+    uint32_t seq = m_nbFrames.load(std::memory_order_relaxed);
+    if (seq > 0) {
+        m_frames[(seq - 1) % DEADLINE_RING_SIZE].dropped = true;
+    }
+    m_nbDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Match the bytes read from the driver with the timestamped frames, and check each frame
+ *
+ * The dropped frames never reach the driver pool: they are checked, then skipped.
+ *
+ * @param size Bytes read
+ */
+void DeadlineMonitor::frameRead(uint32_t size)
+{
+    int64_t now = esp_timer_get_time();
+
+    m_readBytes += size;
+    while (m_readBytes >= ADC_FRAME_SIZE) {
+        m_readBytes -= ADC_FRAME_SIZE;
+
+        uint32_t nbFrames;
+        while ((nbFrames = m_nbFrames.load(std::memory_order_acquire)) != m_nextFrame) {
+            // Keep a free slot for the ISR: the oldest frames may be overwritten while they are copied
+            if (nbFrames - m_nextFrame >= DEADLINE_RING_SIZE) {
+                uint32_t skipped = nbFrames - m_nextFrame - (DEADLINE_RING_SIZE - 1);
+                m_nbUnmonitored.fetch_add(skipped, std::memory_order_relaxed);
+                m_nextFrame += skipped;
+                m_prevTime = 0;
+            }
+            Frame frame = m_frames[m_nextFrame % DEADLINE_RING_SIZE];
+            m_nextFrame++;
+
+            checkFrame(frame, now);
+            if (!frame.dropped) {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check the interval of a frame since the previous one, and its read latency if it was not dropped
+ */
+void DeadlineMonitor::checkFrame(const DeadlineMonitor::Frame &frame, int64_t now)
+{
+    if (frame.dropped) {
+        errorManager.error(PERFORMANCE_ERROR, ADC_SOURCE, "ADC frame dropped: driver pool full", getNbDropped());
+    }
+    else {
+        uint32_t latency = now - frame.time;
+        if (latency > m_maxLatency.load(std::memory_order_relaxed)) {
+            m_maxLatency.store(latency, std::memory_order_relaxed);
+        }
+        if (latency > DEADLINE_LATENCY_BUDGET) {
+            m_nbLate.fetch_add(1, std::memory_order_relaxed);
+            errorManager.error(PERFORMANCE_ERROR, ADC_SOURCE, "ADC frame read late (µs)", latency);
+        }
+    }
+
+    if (m_prevTime == 0) {
+        // First frame, or the chain of intervals is broken: the sample period is measured again from it
+        m_firstTime = frame.time;
+        m_prevTime = frame.time;
+        m_nbPeriods = 0;
+        return;
+    }
+
+    float interval = frame.time - m_prevTime;
+    uint32_t nbPeriods = lroundf(interval / ADC_BLOCK_PERIOD);
+    nbPeriods = (nbPeriods > 0) ? nbPeriods : 1;
+    if (nbPeriods > 1) {
+        m_nbMissed.fetch_add(nbPeriods - 1, std::memory_order_relaxed);
+        errorManager.error(PERFORMANCE_ERROR, ADC_SOURCE, "ADC frames missed", nbPeriods - 1);
+    }
+
+    uint32_t jitter = fabsf(interval - nbPeriods * ADC_BLOCK_PERIOD);
+    uint8_t bin = 0;
+    while (bin < DEADLINE_JITTER_BINS - 1 && jitter >= jitterBounds[bin]) {
+        bin++;
+    }
+    m_jitterBins[bin].fetch_add(1, std::memory_order_relaxed);
+    if (jitter > m_maxJitter.load(std::memory_order_relaxed)) {
+        m_maxJitter.store(jitter, std::memory_order_relaxed);
+    }
+    if (jitter > DEADLINE_JITTER_BUDGET) {
+        m_nbJitterOver.fetch_add(1, std::memory_order_relaxed);
+        errorManager.error(PERFORMANCE_ERROR, ADC_SOURCE, "ADC frame jitter (µs)", jitter);
+    }
+
+    // Real sample period, from the first frame
+    m_nbPeriods += nbPeriods;
+    m_samplePeriod.store((frame.time - m_firstTime) / ((float)m_nbPeriods * ADC_BLOCK_SIZE), std::memory_order_relaxed);
+    m_prevTime = frame.time;
+}
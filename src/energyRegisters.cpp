@@ -0,0 +1,166 @@
+#include "energyRegisters.h"
+#include "errorManager.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "nvs.h"
+
+EnergyRegisters energyRegisters;
+
+// Register units per joule (Q32.32 W.h)
+static constexpr float REGISTER_PER_JOULE = (float)(1ull << ENERGY_FRAC_BITS) / 3600.f;
+
+/**
+ * @brief NVS key of the registers of the current layout
+ *
+ * @param key Output, ENERGY_NVS_KEY_SIZE bytes
+ */
+static void get_key(char* key)
+{
+    snprintf(key, ENERGY_NVS_KEY_SIZE, "%s%u_%u", ENERGY_NVS_KEY, ENERGY_NVS_VERSION, (unsigned)NB_CURRENTS);
+}
+
+
+EnergyRegisters::EnergyRegisters() :
+    m_version(0),
+    m_restored(false),
+    m_lastCheckpointTime(0),
+    m_nbCheckpoints(0),
+    m_nbCheckpointErrors(0)
+{
+    memset(&m_values, 0, sizeof(m_values));
+    memset(&m_saved, 0, sizeof(m_saved));
+}
+
+/**
+ * @brief Restore the registers from the last checkpoint in NVS (NVS must be initialized)
+ *
+ * Without a checkpoint of the current layout, the registers start from 0. If the restore
+ * fails, the checkpoints are disabled until the next boot: the stored registers are kept.
+ *
+ * @return true if the registers are restored, or if there is no checkpoint yet
+ */
+bool EnergyRegisters::begin()
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        m_restored = true;
+        return true;
+    }
+
+    Checkpoint checkpoint;
+    size_t size = sizeof(checkpoint);
+    if (err == ESP_OK) {
+        char key[ENERGY_NVS_KEY_SIZE];
+        get_key(key);
+        err = nvs_get_blob(handle, key, &checkpoint, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        m_restored = true;
+        return true;
+    }
+    if (err != ESP_OK || size != sizeof(checkpoint) || checkpoint.version != ENERGY_NVS_VERSION || checkpoint.nbCurrents != NB_CURRENTS) {
+        errorManager.error(INIT_ERROR, ENERGY_SOURCE, "Error on energy registers restore, checkpoints disabled", err);
+        return false;
+    }
+
+    m_values = checkpoint.values;
+    m_saved = checkpoint.values;
+    m_restored = true;
+    return true;
+}
+
+/**
+ * @brief Add the energy of a period to the registers of each channel (DSP task)
+ *
+ * @param frame Values of the elapsed period
+ */
+void EnergyRegisters::addPeriod(const PeriodFrame &frame)
+{
+    float dt = 1.f / frame.frequency;
+
+    uint32_t version = m_version.load(std::memory_order_relaxed);
+    m_version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        float energy = frame.activePower[i] * dt * REGISTER_PER_JOULE;
+        if (energy >= 0.f) {
+            m_values.importEnergy[i] += (uint64_t)energy;
+        }
+        else {
+            m_values.exportEnergy[i] += (uint64_t)(-energy);
+        }
+    }
+
+    m_version.store(version + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Copy the registers, all from the same period, without blocking the DSP task
+ *
+ * @param values Output
+ */
+void EnergyRegisters::read(EnergyRegisters::Values &values)
+{
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = m_version.load(std::memory_order_acquire);
+        values = m_values;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_version.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+}
+
+/**
+ * @brief Write the registers to NVS if ENERGY_CHECKPOINT_PERIOD has elapsed since the last try and they changed
+ *
+ * The period bounds the NVS writes, hence the flash wear, whatever the caller.
+ *
+ * Nothing is written while the checkpoints are disabled (failed restore).
+ *
+ * @return true if no write failed
+ */
+bool EnergyRegisters::checkpoint()
+{
+    if (!m_restored) {
+        return true;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (m_nbCheckpoints + m_nbCheckpointErrors > 0 && now - m_lastCheckpointTime < ENERGY_CHECKPOINT_PERIOD * 1000000LL) {
+        return true;
+    }
+
+    Checkpoint checkpoint = {ENERGY_NVS_VERSION, NB_CURRENTS, {}};
+    read(checkpoint.values);
+    if (memcmp(&checkpoint.values, &m_saved, sizeof(m_saved)) == 0) {
+        return true;
+    }
+    m_lastCheckpointTime = now;
+
+    char key[ENERGY_NVS_KEY_SIZE];
+    get_key(key);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, key, &checkpoint, sizeof(checkpoint));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        m_nbCheckpointErrors++;
+        return false;
+    }
+
+    m_saved = checkpoint.values;
+    m_nbCheckpoints++;
+    return true;
+}
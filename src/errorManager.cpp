@@ -1,33 +1,184 @@
 #include "errorManager.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
 
 ErrorManager errorManager;
 
-void ErrorManager::error(ErrorCode errorType, std::string className, std::string errorMsg)
+
+ErrorManager::ErrorManager() :
+    m_reservedSeq(0),
+    m_nextSeq(0)
 {
-    switch(errorType){
-        default:
-        case(GENERIC_ERROR) :
-            ESP_LOGI(className.c_str(), "Generic Error : %s", errorMsg.c_str());
-            break;
-        case(INIT_ERROR) :
-            ESP_LOGI(className.c_str(), "Initialization Error : %s", errorMsg.c_str());
-            break;
-        case(IMPOSSIBLE_VALUE_ERROR) :
-            ESP_LOGI(className.c_str(), "Impossible Value Error : %s", errorMsg.c_str());
-            break;
-        case(PERFORMANCE_ERROR) :
-            ESP_LOGI(className.c_str(), "Performance Error : %s", errorMsg.c_str());
-            break;
-        case(AC_FREQ_ERROR) :
-            ESP_LOGI(className.c_str(), "AC Frequency Error : %s", errorMsg.c_str());
-            break;
-        case(TENSION_ERROR) :
-            ESP_LOGI(className.c_str(), "Tension Error : %s", errorMsg.c_str());
+    for (Slot &slot : m_slots) {
+        slot.version.store(0, std::memory_order_relaxed);
+        slot.seq = UINT32_MAX;              // Older than any record
+    }
+    for (Counters &counters : m_counters) {
+        counters.count.store(0, std::memory_order_relaxed);
+        counters.suppressed.store(0, std::memory_order_relaxed);
+        counters.windowSecond.store(0, std::memory_order_relaxed);
+        counters.windowCount.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* ErrorManager::getCodeName(ErrorCode code)
+{
+    static const char* names[NB_ERROR_CODES] = {"Generic", "Initialization", "ImpossibleValue", "Performance", "ACFrequency", "Tension"};
+    return (code < NB_ERROR_CODES) ? names[code] : names[GENERIC_ERROR];
+}
+
+const char* ErrorManager::getSourceName(ErrorSource source)
+{
+    static const char* names[NB_ERROR_SOURCES] = {"Measure", "Tension", "FlashLog", "Rollup", "EnergyRegisters", "Adc", "Tasks", "Http"};
+    return (source < NB_ERROR_SOURCES) ? names[source] : "Unknown";
+}
+
+/**
+ * @brief Count an error, and record it in the ring unless its code is over the rate limit
+ *
+ * Lock-free and allocation-free: callable from any task or ISR (the log line is skipped in an ISR).
+ *
+ * @param code Kind of error
+ * @param source Module that detected it
+ * @param message String literal (only its address is kept)
+ * @param value Faulty value
+ */
+void ErrorManager::error(ErrorCode code, ErrorSource source, const char* message, float value)
+{
+    if (code >= NB_ERROR_CODES) {
+        code = GENERIC_ERROR;
+    }
+    int64_t now = esp_timer_get_time();
+    Counters &counters = m_counters[code];
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+
+    // Fixed one-second window: the first error of a new second restarts the count
+    uint32_t second = now / 1000000;
+    uint32_t windowSecond = counters.windowSecond.load(std::memory_order_relaxed);
+    if (windowSecond != second && counters.windowSecond.compare_exchange_strong(windowSecond, second, std::memory_order_relaxed)) {
+        counters.windowCount.store(0, std::memory_order_relaxed);
+    }
+    if (counters.windowCount.fetch_add(1, std::memory_order_relaxed) >= ERROR_RATE_LIMIT) {
+        counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t seq = m_reservedSeq.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[seq % ERROR_RING_SIZE];
+    uint32_t version = slot.version.load(std::memory_order_relaxed);
+    if ((version & 1) != 0 || !slot.version.compare_exchange_strong(version, version + 1, std::memory_order_relaxed)) {
+        // A writer preempted a whole ring ago still owns the slot: drop rather than wait for it.
+        // The record is published once its slot is reused.
+        counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    if ((int32_t)(slot.seq - seq) > 0) {
+        // Preempted before taking the slot, which already holds a newer record: keep it
+        slot.version.store(version + 2);
+        counters.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot.seq = seq;
+    slot.record = {now, message, value, (uint8_t)code, (uint8_t)source};
+    slot.version.store(version + 2);
+    publish();
+
+    if (!xPortInIsrContext()) {
+        ESP_LOGW(getSourceName(source), "%s Error : %s (%g)", getCodeName(code), message, value);
+    }
+}
+
+/**
+ * @brief Move the published next sequence number over the records written since
+ *
+ * Any writer that completes a slot publishes it, and the records after it that are already
+ * written: the writer of the oldest pending record publishes those completed before it.
+ * A slot already reused by a newer record is passed over (the record is lost anyway).
+ */
+void ErrorManager::publish()
+{
+    uint32_t next = m_nextSeq.load();
+    while (next != m_reservedSeq.load()) {
+        const Slot &slot = m_slots[next % ERROR_RING_SIZE];
+        uint32_t before = slot.version.load();
+        bool written = (int32_t)(slot.seq - next) >= 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((before & 1) != 0 || before != slot.version.load(std::memory_order_relaxed) || !written) {
+            return;         // Its writer publishes it when done
+        }
+        if (m_nextSeq.compare_exchange_weak(next, next + 1)) {
+            next++;
+        }
+    }
+}
+
+/**
+ * @brief Copy a record of the ring
+ *
+ * @return false if the record is no longer (or not yet) in the ring
+ */
+bool ErrorManager::read(uint32_t seq, ErrorRecord &record)
+{
+    const Slot &slot = m_slots[seq % ERROR_RING_SIZE];
+    uint32_t before = slot.version.load(std::memory_order_acquire);
+    bool valid = slot.seq == seq;
+    record = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t after = slot.version.load(std::memory_order_relaxed);
+
+    return valid && (before & 1) == 0 && before == after;
+}
+
+/**
+ * @brief Stream the error counters and the recorded errors from a sequence number as a JSON object
+ *
+ * @param writer Writer bound to the output
+ * @param since Sequence number of the first error (the oldest one if it is no longer in the ring)
+ * @param limit Maximum number of errors to send
+ * @return size_t Number of errors sent
+ */
+size_t ErrorManager::writeJson(JsonWriter &writer, uint32_t since, size_t limit)
+{
+    uint32_t nextSeq = getNextSeq();
+    uint32_t firstSeq = (nextSeq > ERROR_RING_SIZE) ? nextSeq - ERROR_RING_SIZE : 0;
+    size_t nbSent = 0;
+
+    writer.beginObject();
+    writer.addNumber("NextSeq", nextSeq);
+    writer.beginObject("Counters");
+    for (uint8_t code = 0; code < NB_ERROR_CODES; code++) {
+        writer.beginObject(getCodeName(static_cast<ErrorCode>(code)));
+        writer.addNumber("Count", getCount(static_cast<ErrorCode>(code)));
+        writer.addNumber("Suppressed", getNbSuppressed(static_cast<ErrorCode>(code)));
+        writer.endObject();
+    }
+    writer.endObject();
+
+    ErrorRecord record;
+    writer.beginArray("errors");
+    for (uint32_t seq = (since > firstSeq) ? since : firstSeq; seq < nextSeq && nbSent < limit; seq++) {
+        if (!read(seq, record)) {
+            continue;
+        }
+        writer.beginObject();
+        writer.addNumber("seq", seq);
+        writer.addNumber("time(us)", record.time);
+        writer.addString("code", getCodeName(static_cast<ErrorCode>(record.code)));
+        writer.addString("source", getSourceName(static_cast<ErrorSource>(record.source)));
+        writer.addString("message", record.message);
+        writer.addNumber("value", record.value);
+        writer.endObject();
+        if (!writer.flush()) {
             break;
+        }
+        nbSent++;
     }
-    
-    Error error {errorType, className, errorMsg};
-    m_errors.emplace_back(error);
-}
\ No newline at end of file
+    writer.endArray();
+    writer.endObject();
+    writer.flush();
+
+    return nbSent;
+}
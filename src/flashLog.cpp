@@ -0,0 +1,370 @@
+#include "flashLog.h"
+#include "partitionFlash.h"
+#include "measure.h"
+#include "errorManager.h"
+#include "energyRegisters.h"
+
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+
+// Data partition of the log (see partitions.csv)
+static PartitionFlash logPartition(FLASH_LOG_PARTITION);
+
+FlashLog flashLog(logPartition, PACKET_RECORD_SIZE);
+
+// Handle of the log task, notified each time a packet is saved
+TaskHandle_t logTaskHandle = nullptr;
+
+
+FlashLog::FlashLog(FlashStorage &storage, uint16_t payloadSize) :
+    m_storage(storage),
+    m_payloadSize(payloadSize),
+    m_slotSize(payloadSize + FLASH_LOG_SLOT_HEADER_SIZE),
+    m_sectorSize(0),
+    m_nbSectors(0),
+    m_slotsPerSector(0),
+    m_staging(nullptr),
+    m_flushedSeq(0),
+    m_nextSeq(0),
+    m_openSectorSeq(UINT32_MAX),
+    m_nbCorrupted(0),
+    m_nbErased(0),
+    m_nbWriteErrors(0)
+{}
+
+FlashLog::~FlashLog()
+{
+    heap_caps_free(m_staging);
+}
+
+/**
+ * @brief Find the end of the log
+ *
+ * Only the header of each sector is read to find the newest sector, then the slots
+ * of this sector to find the first free one. Sectors written by another log version
+ * or slot size are ignored, and the log starts after them.
+ *
+ * @return true if the log can be used
+ */
+bool FlashLog::begin()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_sectorSize = m_storage.getSectorSize();
+    m_nbSectors = (m_sectorSize > 0) ? m_storage.getSize() / m_sectorSize : 0;
+    m_slotsPerSector = (m_sectorSize > FLASH_LOG_SECTOR_HEADER_SIZE) ? (m_sectorSize - FLASH_LOG_SECTOR_HEADER_SIZE) / m_slotSize : 0;
+    if (m_nbSectors < 2 || m_slotsPerSector == 0) {
+        return false;
+    }
+
+    m_staging = static_cast<uint8_t*>(heap_caps_malloc(FLASH_LOG_BATCH * m_slotSize, MALLOC_CAP_DEFAULT));
+    if (m_staging == nullptr) {
+        return false;
+    }
+
+    bool found = false;
+    bool foundOther = false;
+    uint32_t headSectorSeq = 0;
+    uint32_t otherSectorSeq = 0;
+    SectorHeader header;
+    for (size_t sector = 0; sector < m_nbSectors; sector++) {
+        if (!readSectorHeader(sector, header)) {
+            continue;
+        }
+        if (header.version == FLASH_LOG_VERSION && header.slotSize == m_slotSize && header.sectorSeq % m_nbSectors == sector) {
+            if (!found || header.sectorSeq > headSectorSeq) {
+                headSectorSeq = header.sectorSeq;
+            }
+            found = true;
+        }
+        else if (!foundOther || header.sectorSeq > otherSectorSeq) {
+            otherSectorSeq = header.sectorSeq;
+            foundOther = true;
+        }
+    }
+
+    if (!found || (foundOther && otherSectorSeq > headSectorSeq)) {
+        // Empty or incompatible log: the next record opens a new sector
+        m_nextSeq = foundOther ? (otherSectorSeq + 1) * m_slotsPerSector : 0;
+        m_flushedSeq = m_nextSeq;
+        return true;
+    }
+
+    // The log goes on after the last used slot of the newest sector: a slot is used as soon as a byte is written
+    uint32_t seq = headSectorSeq * m_slotsPerSector;
+    m_nextSeq = seq;
+    uint8_t* slot = m_staging;
+    for (uint16_t i = 0; i < m_slotsPerSector; i++, seq++) {
+        if (!m_storage.read(slotOffset(seq), slot, m_slotSize)) {
+            return false;
+        }
+        for (uint16_t j = 0; j < m_slotSize; j++) {
+            if (slot[j] != 0xFF) {
+                m_nextSeq = seq + 1;
+                break;
+            }
+        }
+    }
+    m_flushedSeq = m_nextSeq;
+    m_openSectorSeq = headSectorSeq;
+
+    return true;
+}
+
+/**
+ * @brief Stage a record, and write the staged records when there are FLASH_LOG_BATCH of them
+ *
+ * @param seq Sequence number of the record: an older one is ignored, a newer one skips the missing records
+ * @param payload Record of payloadSize bytes
+ * @return true if no write failed
+ */
+bool FlashLog::append(uint32_t seq, const uint8_t* payload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_staging == nullptr || seq < m_nextSeq) {
+        return m_staging != nullptr;
+    }
+    bool ok = true;
+    if (seq > m_nextSeq) {
+        ok = flushLocked();
+        m_nextSeq = seq;
+        m_flushedSeq = seq;
+    }
+
+    uint8_t* slot = m_staging + (m_nextSeq - m_flushedSeq) * m_slotSize;
+    memcpy(slot, &m_nextSeq, 4);
+    memcpy(slot + FLASH_LOG_SLOT_HEADER_SIZE, payload, m_payloadSize);
+    uint32_t crc = slotCrc(slot);
+    memcpy(slot + 4, &crc, 4);
+    m_nextSeq++;
+
+    if (m_nextSeq - m_flushedSeq == FLASH_LOG_BATCH) {
+        return flushLocked() && ok;
+    }
+    return ok;
+}
+
+bool FlashLog::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return flushLocked();
+}
+
+/**
+ * @brief Write the staged records, one write per sector, opening the sectors they enter
+ */
+bool FlashLog::flushLocked()
+{
+    bool ok = true;
+    uint32_t seq = m_flushedSeq;
+
+    while (seq != m_nextSeq) {
+        uint32_t sectorSeq = seq / m_slotsPerSector;
+        uint32_t endSeq = (sectorSeq + 1) * m_slotsPerSector;
+        if (endSeq > m_nextSeq) {
+            endSeq = m_nextSeq;
+        }
+
+        if (sectorSeq != m_openSectorSeq) {
+            if (!openSector(sectorSeq)) {
+                // The records of this sector are lost, the next flush opens it again
+                m_openSectorSeq = UINT32_MAX;
+                ok = false;
+                seq = endSeq;
+                continue;
+            }
+            m_openSectorSeq = sectorSeq;
+        }
+
+        if (!m_storage.write(slotOffset(seq), m_staging + (seq - m_flushedSeq) * m_slotSize, (endSeq - seq) * m_slotSize)) {
+            m_nbWriteErrors++;
+            ok = false;
+        }
+        seq = endSeq;
+    }
+    m_flushedSeq = m_nextSeq;
+
+    return ok;
+}
+
+/**
+ * @brief Get a record
+ *
+ * @param seq Sequence number of the record
+ * @param payload Output, payloadSize bytes
+ * @return true if the record exists and is valid
+ */
+bool FlashLog::read(uint32_t seq, uint8_t* payload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_staging == nullptr || seq >= m_nextSeq || seq < getFirstSeqLocked()) {
+        return false;
+    }
+    if (seq >= m_flushedSeq) {
+        memcpy(payload, m_staging + (seq - m_flushedSeq) * m_slotSize + FLASH_LOG_SLOT_HEADER_SIZE, m_payloadSize);
+        return true;
+    }
+
+    SectorHeader header;
+    size_t sector = (seq / m_slotsPerSector) % m_nbSectors;
+    if (!readSectorHeader(sector, header) || header.sectorSeq != seq / m_slotsPerSector || header.slotSize != m_slotSize) {
+        return false;
+    }
+
+    uint8_t slotHeader[FLASH_LOG_SLOT_HEADER_SIZE];
+    size_t offset = slotOffset(seq);
+    if (!m_storage.read(offset, slotHeader, FLASH_LOG_SLOT_HEADER_SIZE)
+        || !m_storage.read(offset + FLASH_LOG_SLOT_HEADER_SIZE, payload, m_payloadSize)) {
+        return false;
+    }
+
+    uint32_t slotSeq;
+    uint32_t crc;
+    memcpy(&slotSeq, slotHeader, 4);
+    memcpy(&crc, slotHeader + 4, 4);
+    if (slotSeq == UINT32_MAX && crc == UINT32_MAX) {
+        // Never written: a record skipped after a restart or a write error
+        return false;
+    }
+    if (slotSeq != seq || crc != esp_rom_crc32_le(esp_rom_crc32_le(0, slotHeader, 4), payload, m_payloadSize)) {
+        m_nbCorrupted++;
+        return false;
+    }
+    return true;
+}
+
+uint32_t FlashLog::getFirstSeq()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getFirstSeqLocked();
+}
+
+uint32_t FlashLog::getNextSeq()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextSeq;
+}
+
+uint32_t FlashLog::getFirstSeqLocked()
+{
+    if (m_slotsPerSector == 0) {
+        return 0;
+    }
+
+    // The oldest sector is the one erased next
+    uint32_t headSectorSeq = m_nextSeq / m_slotsPerSector;
+    return (headSectorSeq >= m_nbSectors - 1) ? (headSectorSeq - (m_nbSectors - 1)) * m_slotsPerSector : 0;
+}
+
+bool FlashLog::readSectorHeader(size_t sector, SectorHeader &header)
+{
+    if (!m_storage.read(sector * m_sectorSize, &header, sizeof(header))) {
+        return false;
+    }
+    return header.magic == FLASH_LOG_MAGIC
+        && header.crc == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, crc));
+}
+
+/**
+ * @brief Erase the sector of a sector sequence number (the oldest one) and write its header
+ */
+bool FlashLog::openSector(uint32_t sectorSeq)
+{
+    size_t sector = sectorSeq % m_nbSectors;
+    if (!m_storage.eraseSector(sector)) {
+        m_nbWriteErrors++;
+        return false;
+    }
+    m_nbErased++;
+
+    SectorHeader header = {FLASH_LOG_MAGIC, FLASH_LOG_VERSION, m_slotSize, sectorSeq, 0};
+    header.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, crc));
+    if (!m_storage.write(sector * m_sectorSize, &header, sizeof(header))) {
+        m_nbWriteErrors++;
+        return false;
+    }
+    return true;
+}
+
+size_t FlashLog::slotOffset(uint32_t seq)
+{
+    size_t sector = (seq / m_slotsPerSector) % m_nbSectors;
+    return sector * m_sectorSize + FLASH_LOG_SECTOR_HEADER_SIZE + (seq % m_slotsPerSector) * m_slotSize;
+}
+
+uint32_t FlashLog::slotCrc(const uint8_t* slot)
+{
+    return esp_rom_crc32_le(esp_rom_crc32_le(0, slot, 4), slot + FLASH_LOG_SLOT_HEADER_SIZE, m_payloadSize);
+}
+
+
+/**
+ * @brief Write the staged records before a software restart (called by esp_restart)
+ */
+static void log_shutdown()
+{
+    flashLog.flush();
+}
+
+/**
+ * @brief Mount the log
+ *
+ * The staged records are written by esp_restart, but up to FLASH_LOG_BATCH - 1 of them
+ * may have been lost at the last power cut or panic, so the new packets are numbered
+ * after them: a number is never reused.
+ *
+ * @return uint32_t Sequence number of the first new packet
+ */
+uint32_t log_init()
+{
+    if (!logPartition.begin() || !flashLog.begin()) {
+        errorManager.error(INIT_ERROR, FLASH_LOG_SOURCE, "Error on log initialization: partition " FLASH_LOG_PARTITION);
+        return 0;
+    }
+    if (esp_register_shutdown_handler(log_shutdown) != ESP_OK) {
+        errorManager.error(INIT_ERROR, FLASH_LOG_SOURCE, "Error on log shutdown handler registration");
+    }
+    return flashLog.getNextSeq() + FLASH_LOG_BATCH;
+}
+
+/**
+ * @brief Log task function.
+ *
+ * This function waits for notifications from Measure::save, appends the new
+ * packets of the ring to the log (mounted by log_init), and checkpoints the
+ * energy registers (rate-limited by EnergyRegisters::checkpoint).
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void log_task(void *pvParameters) {
+    static uint8_t record[PACKET_RECORD_SIZE];
+    static Measure::Data data;
+    uint32_t nextSeq = flashLog.getNextSeq();
+
+    while(1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (flashLog.isMounted()) {
+            // One packet is copied at a time, so the ring lock is never held during a flash write
+            uint32_t firstSeq = measure.getFirstSeq();
+            uint32_t endSeq = measure.getNextSeq();
+            for (uint32_t seq = (nextSeq > firstSeq) ? nextSeq : firstSeq; seq < endSeq; seq++) {
+                if (!measure.getPacket(seq, data)) {
+                    continue;
+                }
+                Measure::encodeRecord(record, seq, data);
+                if (!flashLog.append(seq, record)) {
+                    errorManager.error(GENERIC_ERROR, FLASH_LOG_SOURCE, "Error on log write", seq);
+                }
+            }
+            if (endSeq > nextSeq) {
+                nextSeq = endSeq;
+            }
+        }
+        if (!energyRegisters.checkpoint()) {
+            errorManager.error(GENERIC_ERROR, ENERGY_SOURCE, "Error on energy registers checkpoint");
+        }
+    }
+}
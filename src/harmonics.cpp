@@ -0,0 +1,168 @@
+#include "harmonics.h"
+
+#include <math.h>
+
+Harmonics harmonics;
+
+// Handle of the harmonic task, notified each time a period is pushed into the ring
+TaskHandle_t harmonicTaskHandle = nullptr;
+
+Harmonics::Harmonics()
+{
+    // A period is exactly NB_SAMPLES points, so the rank k is the bin k of a NB_SAMPLES points DFT
+    for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+        m_coeffs[k] = 2.f * cosf(2.f * (float)M_PI * (k + 1) / NB_SAMPLES);
+    }
+    init();
+}
+
+void Harmonics::init()
+{
+    m_nbPeriods = 0;
+    for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+        m_thdMin[i] = 999999.f;
+        m_thdMax[i] = 0.f;
+        m_thdSum[i] = 0.f;
+        for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+            m_harmonicSum[i][k] = 0.f;
+        }
+    }
+}
+
+/**
+ * @brief Get a buffer for the next period, after collecting the results of the analyzed periods
+ *
+ * @return PeriodBuffer* Buffer to fill, nullptr if the ring is full (the period is skipped)
+ */
+PeriodBuffer* Harmonics::beginPeriod()
+{
+    collect();
+    return m_ring.reserve();
+}
+
+/**
+ * @brief Hand the period filled by the resampler over to the harmonic task
+ */
+void Harmonics::endPeriod()
+{
+    m_ring.commit();
+    xTaskNotifyGive(harmonicTaskHandle);
+}
+
+/**
+ * @brief Amplitude of the first NB_HARMONICS ranks of one period (Goertzel algorithm)
+ *
+ * @param samples NB_SAMPLES points of the period
+ * @param magnitudes Amplitude of each rank (output)
+ */
+void Harmonics::analyze(const float* samples, float* magnitudes)
+{
+    const float scale = 2.f / NB_SAMPLES;
+
+    for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+        float coeff = m_coeffs[k];
+        float s1 = 0.f;
+        float s2 = 0.f;
+        for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+            float s0 = samples[n] + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        magnitudes[k] = sqrtf(fmaxf(s1 * s1 + s2 * s2 - coeff * s1 * s2, 0.f)) * scale;
+    }
+}
+
+/**
+ * @brief Analyze every period waiting in the ring and hand the results back to the DSP task
+ *
+ * A period stays in the ring while the result ring is full: it is analyzed at the next
+ * notification, once the DSP task has collected the results.
+ */
+void Harmonics::process()
+{
+    PeriodBuffer* period;
+    PeriodHarmonics* result;
+    float magnitudes[NB_HARMONICS];
+
+    while ((period = m_ring.front()) != nullptr && (result = m_results.reserve()) != nullptr) {
+        for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+            analyze(period->samples[i], magnitudes);
+
+            float fundamental = magnitudes[0];
+            float distortion = 0.f;
+            for (uint8_t k = 1; k < NB_HARMONICS; k++) {
+                distortion += magnitudes[k] * magnitudes[k];
+            }
+            result->thd[i] = (fundamental > 0.f) ? 100.f * sqrtf(distortion) / fundamental : 0.f;
+            for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+                result->harmonics[i][k] = (fundamental > 0.f) ? 100.f * magnitudes[k] / fundamental : 0.f;
+            }
+        }
+
+        m_results.commit();
+        m_ring.release();
+    }
+}
+
+/**
+ * @brief Add the results handed back by the harmonic task to the statistics (DSP task)
+ */
+void Harmonics::collect()
+{
+    PeriodHarmonics* result;
+
+    while ((result = m_results.front()) != nullptr) {
+        for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+            m_thdMin[i] = fminf(m_thdMin[i], result->thd[i]);
+            m_thdMax[i] = fmaxf(m_thdMax[i], result->thd[i]);
+            m_thdSum[i] += result->thd[i];
+            for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+                m_harmonicSum[i][k] += result->harmonics[i][k];
+            }
+        }
+        m_nbPeriods++;
+        m_results.release();
+    }
+}
+
+/**
+ * @brief Get the harmonic content of each analyzed channel since the last call and reset the statistics
+ *
+ * @param data Array of NB_FFT_CHANNELS + 1 results, the tension first
+ */
+void Harmonics::getData(HarmonicData* data)
+{
+    collect();
+
+    float invNbPeriods = (m_nbPeriods > 0) ? 1.f / m_nbPeriods : 0.f;
+    for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+        data[i].thd = RangeData({m_nbPeriods > 0 ? m_thdMin[i] : 0.f, m_thdMax[i], m_thdSum[i] * invNbPeriods});
+        for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+            data[i].harmonics[k] = m_harmonicSum[i][k] * invNbPeriods;
+        }
+    }
+    init();
+}
+
+void Harmonics::writeJson(JsonWriter &writer, const char* key, const HarmonicData &data)
+{
+    writer.beginObject(key);
+    Signal::writeJson(writer, "THD(%)", data.thd);
+    writer.addNumberArray("harmonics(%)", data.harmonics, NB_HARMONICS);
+    writer.endObject();
+}
+
+/**
+ * @brief Harmonic task function.
+ *
+ * This function waits for notifications from the DSP task and analyzes the
+ * recorded periods.
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void harmonic_task(void *pvParameters) {
+    while(1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        harmonics.process();
+    }
+}
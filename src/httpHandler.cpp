@@ -1,68 +1,143 @@
-/*#include "httpHandler.h"
+#include "httpHandler.h"
+#include "errorManager.h"
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include <esp_timer.h>
 
+HttpHandler httpHandler;
+TaskHandle_t httpWorkerHandles[HTTP_NB_WORKERS] = {};
 
-void HttpHandler::taskWrapper(void* param)
-{
-    static_cast<HttpHandler*>(param)->task();
-}
 
+HttpHandler::HttpHandler() :
+    m_queue(nullptr),
+    m_nbEndpoints(0)
+{}
 
-void HttpHandler::task()
+/**
+ * @brief Create the request queue, before the workers and the server start
+ *
+ * @return true if the queue is created
+ */
+bool HttpHandler::begin()
 {
-    while (1) {
-        if (xSemaphoreTake(request_mutex, portMAX_DELAY) == pdTRUE) {
-            if (request_data.new_request) {
-                // Process the request here
-                // This code is guaranteed to run on core 1
-                if (handler_function) {
-                    handler_function(request_data.req);
-                }
-                request_data.new_request = false;
-            }
-            xSemaphoreGive(request_mutex);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
+    m_queue = xQueueCreate(HTTP_QUEUE_DEPTH, sizeof(Request));
+    if (m_queue == nullptr) {
+        errorManager.error(INIT_ERROR, HTTP_SOURCE, "Error on request queue allocation (requests)", HTTP_QUEUE_DEPTH);
+        return false;
     }
+    return true;
 }
 
-
-void HttpHandler::start()
+/**
+ * @brief Register a handler served by the workers
+ *
+ * @param server HTTP server
+ * @param uri URI (string literal)
+ * @param method HTTP method
+ * @param handler Handler, called from a worker with its own copy of the request
+ * @return esp_err_t ESP_OK if the URI is registered
+ */
+esp_err_t HttpHandler::registerUri(httpd_handle_t server, const char* uri, httpd_method_t method, HttpHandler::HandlerFunction handler)
 {
-    xTaskCreatePinnedToCore(taskWrapper, "HTTP Handler Task", 4096, this, 5, &task_handle, 1);
-}
+    if (m_nbEndpoints >= HTTP_MAX_ENDPOINTS) {
+        return ESP_ERR_NO_MEM;
+    }
+    Endpoint &endpoint = m_endpoints[m_nbEndpoints++];
+    endpoint.uri = uri;
+    endpoint.handler = handler;
+    endpoint.nbRequests = 0;
+    endpoint.nbRejected = 0;
+    endpoint.nbFailed = 0;
+    endpoint.latency.init();
+    endpoint.maxLatency = 0.f;
+    endpoint.maxWait = 0.f;
 
+    httpd_uri_t httpdUri = {
+        .uri      = uri,
+        .method   = method,
+        .handler  = dispatch,
+        .user_ctx = &endpoint
+    };
+    return httpd_register_uri_handler(server, &httpdUri);
+}
 
-esp_err_t HttpHandler::handleRequest(httpd_req_t *req)
+/**
+ * @brief Hand a request over to the workers (server task), or answer 503 if the queue is full
+ */
+esp_err_t HttpHandler::dispatch(httpd_req_t *req)
 {
-    if (xSemaphoreTake(request_mutex, portMAX_DELAY) == pdTRUE) {
-        request_data.req = req;
-        request_data.new_request = true;
-        xSemaphoreGive(request_mutex);
-    }
+    Endpoint* endpoint = static_cast<Endpoint*>(req->user_ctx);
+    Request request = {nullptr, endpoint, esp_timer_get_time()};
 
-    // Wait for the core 1 task to process the request
-    while (1) {
-        if (xSemaphoreTake(request_mutex, portMAX_DELAY) == pdTRUE) {
-            if (!request_data.new_request) {
-                xSemaphoreGive(request_mutex);
-                break;
-            }
-            xSemaphoreGive(request_mutex);
+    if (httpd_req_async_handler_begin(req, &request.req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Request copy failed");
+    }
+    if (xQueueSend(httpHandler.m_queue, &request, 0) != pdTRUE) {
+        httpd_req_async_handler_complete(request.req);
+        {
+            std::lock_guard<std::mutex> lock(httpHandler.m_statsMutex);
+            endpoint->nbRejected++;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, "Server busy", HTTPD_RESP_USE_STRLEN);
     }
 
     return ESP_OK;
 }
 
-
-HttpHandler::~HttpHandler()
+/**
+ * @brief Serve the queued requests (worker task)
+ *
+ * When a handler fails, its connection is closed, as the server does for a synchronous handler.
+ */
+void HttpHandler::task()
 {
-    if (task_handle) {
-        vTaskDelete(task_handle);
+    Request request;
+
+    while(1) {
+        if (xQueueReceive(m_queue, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        float wait = (esp_timer_get_time() - request.time) / 1000.f;
+        esp_err_t err = request.endpoint->handler(request.req);
+        if (err != ESP_OK) {
+            httpd_sess_trigger_close(request.req->handle, httpd_req_to_sockfd(request.req));
+        }
+        httpd_req_async_handler_complete(request.req);
+        float latency = (esp_timer_get_time() - request.time) / 1000.f;
+
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        Endpoint &endpoint = *request.endpoint;
+        endpoint.nbRequests++;
+        endpoint.nbFailed += (err != ESP_OK) ? 1 : 0;
+        endpoint.latency.add(latency);
+        endpoint.maxLatency = (latency > endpoint.maxLatency) ? latency : endpoint.maxLatency;
+        endpoint.maxWait = (wait > endpoint.maxWait) ? wait : endpoint.maxWait;
     }
-    vSemaphoreDelete(request_mutex);
-}*/
+}
+
+void HttpHandler::getStats(size_t endpoint, HttpHandler::Stats &stats)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    const Endpoint &source = m_endpoints[endpoint];
+    stats.uri = source.uri;
+    stats.nbRequests = source.nbRequests;
+    stats.nbRejected = source.nbRejected;
+    stats.nbFailed = source.nbFailed;
+    stats.meanLatency = (source.nbRequests > 0) ? source.latency.get() / source.nbRequests : 0.f;
+    stats.maxLatency = source.maxLatency;
+    stats.maxWait = source.maxWait;
+}
+
+
+/**
+ * @brief HTTP worker task function.
+ *
+ * This function serves the requests queued by the HTTP server (see taskTable.cpp
+ * for the number of workers and their placement).
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void http_worker_task(void *pvParameters) {
+    httpHandler.task();
+}
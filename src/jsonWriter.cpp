@@ -0,0 +1,165 @@
+#include "jsonWriter.h"
+
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+JsonWriter::JsonWriter(JsonSink sink, void* ctx) :
+    m_sink(sink),
+    m_ctx(ctx),
+    m_size(0),
+    m_hasItem(0),
+    m_depth(0),
+    m_ok(true)
+{}
+
+void JsonWriter::beginObject(const char* key)
+{
+    begin(key, '{');
+}
+
+void JsonWriter::endObject()
+{
+    end('}');
+}
+
+void JsonWriter::beginArray(const char* key)
+{
+    begin(key, '[');
+}
+
+void JsonWriter::endArray()
+{
+    end(']');
+}
+
+void JsonWriter::addNumber(const char* key, double val)
+{
+    writeKey(key);
+    writeNumber(val);
+}
+
+void JsonWriter::addNumberArray(const char* key, const float* vals, size_t nbVals)
+{
+    beginArray(key);
+    for (size_t i = 0; i < nbVals; i++) {
+        addNumber(nullptr, vals[i]);
+    }
+    endArray();
+}
+
+void JsonWriter::addString(const char* key, const char* val)
+{
+    writeKey(key);
+    write('"');
+    write(val, strlen(val));
+    write('"');
+}
+
+void JsonWriter::addBool(const char* key, bool val)
+{
+    writeKey(key);
+    if (val) {
+        write("true", 4);
+    }
+    else {
+        write("false", 5);
+    }
+}
+
+/**
+ * @brief Hand the buffered bytes over to the sink
+ *
+ * @return true if every byte written so far has been accepted by the sink
+ */
+bool JsonWriter::flush()
+{
+    if (m_ok && m_size > 0) {
+        m_ok = m_sink(m_ctx, m_buffer, m_size);
+    }
+    m_size = 0;
+    return m_ok;
+}
+
+void JsonWriter::begin(const char* key, char open)
+{
+    writeKey(key);
+    write(open);
+    if (m_depth < JSON_MAX_DEPTH - 1) {
+        m_depth++;
+        m_hasItem &= ~(1UL << m_depth);
+    }
+}
+
+void JsonWriter::end(char close)
+{
+    if (m_depth > 0) {
+        m_depth--;
+    }
+    write(close);
+}
+
+/**
+ * @brief Write the separator of a new item and its key (nullptr inside an array)
+ */
+void JsonWriter::writeKey(const char* key)
+{
+    if (m_hasItem & (1UL << m_depth)) {
+        write(',');
+    }
+    m_hasItem |= (1UL << m_depth);
+
+    if (key != nullptr) {
+        write('"');
+        write(key, strlen(key));
+        write("\":", 2);
+    }
+}
+
+/**
+ * @brief Format a number as cJSON_PrintUnformatted does
+ *
+ * Integers are printed as such, other values with the shortest of 15 or 17
+ * significant digits that reads back to the same double.
+ */
+void JsonWriter::writeNumber(double val)
+{
+    char number[32];
+    int length;
+
+    if (isnan(val) || isinf(val)) {
+        length = snprintf(number, sizeof(number), "null");
+    }
+    else {
+        int intVal = (val >= INT_MAX) ? INT_MAX : (val <= (double)INT_MIN) ? INT_MIN : (int)val;
+        if (val == (double)intVal) {
+            length = snprintf(number, sizeof(number), "%d", intVal);
+        }
+        else {
+            length = snprintf(number, sizeof(number), "%1.15g", val);
+            double test = strtod(number, nullptr);
+            if (fabs(test - val) > fmax(fabs(test), fabs(val)) * DBL_EPSILON) {
+                length = snprintf(number, sizeof(number), "%1.17g", val);
+            }
+        }
+    }
+    write(number, length);
+}
+
+void JsonWriter::write(const char* data, size_t size)
+{
+    while (m_ok && size > 0) {
+        size_t len = (size < JSON_CHUNK_SIZE - m_size) ? size : JSON_CHUNK_SIZE - m_size;
+        memcpy(m_buffer + m_size, data, len);
+        m_size += len;
+        data += len;
+        size -= len;
+        if (m_size == JSON_CHUNK_SIZE) {
+            flush();
+        }
+    }
+}
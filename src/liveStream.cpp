@@ -0,0 +1,248 @@
+#include "liveStream.h"
+#include "packetRecord.h"
+
+#include <errno.h>
+#include <lwip/sockets.h>
+
+LiveStream liveStream;
+
+// Handle of the stream task, notified each time a batch of periods is complete
+TaskHandle_t streamTaskHandle = nullptr;
+
+// Bytes of the current message already in the socket (HTTP server task only)
+static size_t sentBytes = 0;
+
+
+/**
+ * @brief Send function of the stream sessions: never waits for room in the socket
+ *
+ * @return int Bytes sent, or HTTPD_SOCK_ERR_TIMEOUT if the socket is full
+ */
+static int send_non_blocking(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    int ret = send(sockfd, buf, buf_len, flags | MSG_DONTWAIT);
+    if (ret < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    }
+    sentBytes += ret;
+    return ret;
+}
+
+/**
+ * @brief Size of an unmasked WebSocket frame (server to client), header included
+ */
+static size_t ws_frame_size(size_t payloadSize)
+{
+    size_t headerSize = (payloadSize < 126) ? 2 : (payloadSize <= UINT16_MAX) ? 4 : 10;
+    return headerSize + payloadSize;
+}
+
+
+LiveStream::LiveStream() :
+    m_server(nullptr),
+    m_nbClients(0),
+    m_nbSent(0),
+    m_nbDropped(0)
+{
+    for (Client &client : m_clients) {
+        client.stream = this;
+        client.fd = -1;
+        client.busy = false;
+    }
+}
+
+void LiveStream::begin(httpd_handle_t server)
+{
+    m_server = server;
+}
+
+/**
+ * @brief Push the values of a period (DSP task), without blocking
+ *
+ * If the stream task is late and the ring is full, the frame is dropped and counted by the ring.
+ *
+ * @param frame Values of the elapsed period
+ */
+void LiveStream::push(const PeriodFrame &frame)
+{
+    m_frames.push(frame);
+    if (frame.seq % LIVE_STREAM_BATCH == 0 && streamTaskHandle != nullptr) {
+        xTaskNotifyGive(streamTaskHandle);
+    }
+}
+
+/**
+ * @brief Subscribe a WebSocket session (HTTP server task, after the handshake)
+ *
+ * The session then sends without blocking: a full socket makes the client miss the
+ * message instead of blocking the HTTP server task.
+ *
+ * @param fd Socket of the session
+ * @return true if there was a free slot
+ */
+bool LiveStream::addClient(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Client &client : m_clients) {
+        if (client.fd == fd) {
+            return true;
+        }
+    }
+    for (Client &client : m_clients) {
+        if (client.fd < 0 && !client.busy) {
+            if (httpd_sess_set_send_override(m_server, fd, send_non_blocking) != ESP_OK) {
+                return false;
+            }
+            client.fd = fd;
+            client.nbDropped = 0;
+            m_nbClients++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LiveStream::removeClient(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Client &client : m_clients) {
+        if (client.fd == fd) {
+            client.fd = -1;
+            m_nbClients--;
+        }
+    }
+}
+
+/**
+ * @brief Send the frames of the ring in batches of LIVE_STREAM_BATCH periods
+ */
+void LiveStream::task()
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint8_t nbFrames;
+        do {
+            nbFrames = 0;
+            while (nbFrames < LIVE_STREAM_BATCH && m_frames.pop(m_batch[nbFrames])) {
+                nbFrames++;
+            }
+            if (nbFrames > 0) {
+                sendBatch(nbFrames);
+            }
+        } while (nbFrames == LIVE_STREAM_BATCH);
+    }
+}
+
+/**
+ * @brief Queue a batch for each client to the HTTP server task, which owns the sockets
+ *
+ * A client whose previous batch is not sent yet misses this one: a slow client never
+ * delays the others, nor the measure.
+ *
+ * @param nbFrames Number of frames in m_batch
+ */
+void LiveStream::sendBatch(uint8_t nbFrames)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Client &client : m_clients) {
+        if (client.fd < 0) {
+            continue;
+        }
+        if (client.busy) {
+            client.nbDropped += nbFrames;
+            m_nbDropped += nbFrames;
+            continue;
+        }
+
+        client.nbFrames = nbFrames;
+        client.size = encodeBatch(client.message, nbFrames);
+        RecordWriter header(client.message + 4);
+        header.u32(client.nbDropped);
+
+        client.busy = true;
+        if (httpd_queue_work(m_server, sendWork, &client) != ESP_OK) {
+            client.busy = false;
+            client.nbDropped += nbFrames;
+            m_nbDropped += nbFrames;
+        }
+    }
+}
+
+/**
+ * @brief Encode a message (see liveStream.h for the layout), with no drop count
+ *
+ * @return size_t Size of the message
+ */
+size_t LiveStream::encodeBatch(uint8_t* buffer, uint8_t nbFrames)
+{
+    RecordWriter writer(buffer);
+    writer.u16(LIVE_FRAME_SIZE);
+    writer.u8(NB_CURRENTS);
+    writer.u8(nbFrames);
+    writer.u32(0);
+
+    for (uint8_t i = 0; i < nbFrames; i++) {
+        const PeriodFrame &frame = m_batch[i];
+        writer.u32(frame.seq);
+        writer.i64(frame.time);
+        writer.f32(frame.frequency);
+        writer.f32(frame.tensionRms);
+        for (float val : frame.currentRms) {
+            writer.f32(val);
+        }
+        for (float val : frame.activePower) {
+            writer.f32(val);
+        }
+    }
+    return writer.size();
+}
+
+/**
+ * @brief Send the batch of a client (HTTP server task), without blocking
+ *
+ * If the socket has no room for the message, the client misses it. If the message was
+ * only partly sent, or on another error, the session is closed (which unsubscribes the
+ * client): the rest of its stream could not be decoded.
+ */
+void LiveStream::sendWork(void* arg)
+{
+    Client* client = static_cast<Client*>(arg);
+    LiveStream* stream = client->stream;
+
+    if (client->fd >= 0) {
+        httpd_ws_frame_t frame = {};
+        frame.final = true;
+        frame.type = HTTPD_WS_TYPE_BINARY;
+        frame.payload = client->message;
+        frame.len = client->size;
+        sentBytes = 0;
+        // A short write is not an error for the server: the sent bytes tell whether the frame is complete
+        bool ok = httpd_ws_send_frame_async(stream->m_server, client->fd, &frame) == ESP_OK
+            && sentBytes == ws_frame_size(client->size);
+        if (ok) {
+            stream->m_nbSent += client->nbFrames;
+        }
+        else {
+            client->nbDropped += client->nbFrames;
+            stream->m_nbDropped += client->nbFrames;
+            if (sentBytes > 0) {
+                httpd_sess_trigger_close(stream->m_server, client->fd);
+            }
+        }
+    }
+    client->busy = false;
+}
+
+
+/**
+ * @brief Stream task function.
+ *
+ * This function sends the per-period values pushed by the DSP task to the
+ * WebSocket clients of /api/stream.
+ *
+ * @param pvParameters Pointer to the task parameters (not used in this case).
+ */
+void stream_task(void *pvParameters) {
+    liveStream.task();
+}
@@ -2,11 +2,19 @@
 #include <freertos/task.h>
 #include <freertos/semphr.h>
 #include <esp_system.h>
+#include <esp_log.h>
 #include "nvs_flash.h"
 
 #include "adc.h"
 #include "wifi.h"
 #include "measure.h"
+#include "harmonics.h"
+#include "flashLog.h"
+#include "liveStream.h"
+#include "rollup.h"
+#include "energyRegisters.h"
+#include "taskTable.h"
+#include "httpHandler.h"
 
 
 extern "C" void app_main(void) {
@@ -18,10 +26,22 @@ extern "C" void app_main(void) {
     ESP_ERROR_CHECK(ret);
     
     mutex = xSemaphoreCreateMutex();
+
+    // Restore the energy registers. If it fails, they count from 0 for this boot only:
+    // the stored ones are kept, and the registers are not checkpointed over them
+    if (!energyRegisters.begin()) {
+        ESP_LOGE("app_main", "Energy registers not restored: checkpoints disabled until the next boot");
+    }
+
+    // Mount the packet log, then allocate the packet ring before the measure starts:
+    // the new packets are numbered after the logged ones
+    measure.begin(log_init());
+    rollup.begin();
     
     wifi_init_sta();
     
-    xTaskCreatePinnedToCore(adc_task, "ADC Task", 4096, NULL, 5, NULL, 0);
+    httpHandler.begin();
+    tasks_start();
 
     start_webserver();
     
@@ -1,29 +1,26 @@
 #include "measure.h"
 #include "errorManager.h"
 #include "ntp.h"
+#include "flashLog.h"
+#include "liveStream.h"
+#include "rollup.h"
+#include "profiler.h"
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/semphr.h>
 #include <esp_timer.h>
 
 Measure measure;
 
 Measure::Measure() :
-    m_currents(NB_CURRENTS),
-    m_data(nullptr)
+    m_packets(PACKET_RING_OVERWRITE ? PacketRing<Data, PACKET_RING_SIZE>::OVERWRITE_OLDEST : PacketRing<Data, PACKET_RING_SIZE>::DROP_NEWEST),
+    m_seqBase(0),
+    m_ackedSeq(0),
+    m_nbPeriods(0)
 {
-    m_data = cJSON_CreateObject();
-    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
-        m_currents[i].setChannelId(i);
-    }
     init();
 }
 
 Measure::~Measure()
-{
-    cJSON_Delete(m_data);
-}
+{}
 
 void Measure::init()
 {
@@ -31,27 +28,63 @@ void Measure::init()
     float freq = 1. / m_timerPeriod;
 
     if (freq > MAX_AC_FREQ && (freq < MIN_AC_FREQ)) {
-        errorManager.error(INIT_ERROR, "Measure", "Error on frequency initialization: " + std::to_string(freq));
+        errorManager.error(INIT_ERROR, MEASURE_SOURCE, "Error on frequency initialization", freq);
     }
  
     m_tension.init();
-    for (uint8_t i = 0; i != NB_CURRENTS; i++) {
-        m_currents[i].init();
-    }
+    m_currents.init();
+    m_resampler.init();
 
     m_initState = INIT;
 }
 
+/**
+ * @brief Allocate the packet ring, once at startup, so that the measure path never allocates
+ * 
+ * @param firstSeq Sequence number of the first packet, after the ones of the flash log
+ * @return true if the ring is allocated (otherwise every packet is dropped)
+ */
+bool Measure::begin(uint32_t firstSeq)
+{
+    m_seqBase = firstSeq;
+    m_ackedSeq = firstSeq;
+    if (!m_packets.allocate()) {
+        errorManager.error(INIT_ERROR, MEASURE_SOURCE, "Error on packet ring allocation (bytes)", PACKET_RING_SIZE * sizeof(Data));
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Process a block of demultiplexed ADC samples
+ * 
+ * @param block Per-channel samples of one DMA frame
+ */
+void Measure::adcBlockCallback(const AdcBlock &block)
+{
+    PROFILE_SCOPE(PROFILE_BLOCK_DSP);
+    uint16_t data[NB_CHANNELS];
+
+    for (uint16_t i = 0; i < block.nbSamples; i++) {
+        for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+            data[j] = block.samples[j][i];
+        }
+        adcCallback(data);
+    }
+}
+
 
-void Measure::adcCallback(uint32_t* data)
+void Measure::adcCallback(const uint16_t* data)
 {
     //m_periodTimeBuffer[m_iPeriodTimeBuffer] = m_periodTime;
     //m_iPeriodTimeBuffer++;
 
-    m_tension.setVal(CALIB_A_COEFFS[TENSION_ID] * ((float)data[TENSION_ID] - (float)data[VREF_ID]) + CALIB_B_COEFFS[TENSION_ID]);
+    m_tension.setRawVal(data);
+    m_currents.setRawVals(data);
     
-    float czPoint(0.);
-    float deltaT(0.);
+    float czPoint(0.f);
+    float deltaT(m_timerPeriod);
 
     switch(m_initState) {
         case INIT:
@@ -61,12 +94,11 @@ void Measure::adcCallback(uint32_t* data)
 
         case WAITING_ZC:
             if (m_tension.isCrossingZero(&czPoint)) {
-                deltaT = m_timerPeriod * (1. - czPoint);
-                m_totalMeasureTime = 0.;
+                deltaT = m_timerPeriod * (1.f - czPoint);
+                m_totalMeasureTime.init();
                 m_tension.calcSample(deltaT, false);
-                for(Current &current : m_currents) {
-                    current.calcSample(deltaT, false);
-                }
+                m_currents.calcPartialSample(tensionSample(), 1.f - czPoint);
+                m_resampler.startPeriod(data, czPoint);
                 m_periodTime = deltaT;
                 m_initState = NORMAL_PHASE;
             }
@@ -79,137 +111,403 @@ void Measure::adcCallback(uint32_t* data)
     }
 
     if (m_tension.isCrossingZero(&czPoint)) {
+        PROFILE_SCOPE(PROFILE_PERIOD_DSP);
 
         // Robustess check
-        if (m_periodTime < (1. / MAX_AC_FREQ)) {
-            errorManager.error(AC_FREQ_ERROR, "Measure", "Error on AC frequency calculation : " + std::to_string(1. / m_periodTime));
+        if (m_periodTime < (1.f / MAX_AC_FREQ)) {
+            errorManager.error(AC_FREQ_ERROR, MEASURE_SOURCE, "Error on AC frequency calculation", 1.f / m_periodTime);
         }
 
         // Calculation of the last point of the previous period
         deltaT = m_timerPeriod * czPoint;
         m_tension.calcSample(deltaT, false);
-        for(Current &current : m_currents) {
-            current.calcSample(deltaT, false);
-        }
+        m_currents.calcPartialSample(tensionSample(), czPoint);
         
         // update current time with the last step of the previous period
         m_periodTime += deltaT;
 
         // Calculation of the complete previous period
-        m_tension.calcPeriod(m_periodTime, m_totalMeasureTime);
-        for(Current &current : m_currents) {
-            current.calcPeriod(m_periodTime, m_totalMeasureTime);
+        m_tension.calcPeriod(m_periodTime);
+        m_currents.calcPeriod(m_tension.getLastRms(), m_periodTime);
+
+        // Values of the period: rollup windows, and live stream when a client listens
+        PeriodFrame frame;
+        fillPeriod(frame);
+        rollup.addPeriod(frame);
+        energyRegisters.addPeriod(frame);
+        if (liveStream.isActive()) {
+            liveStream.push(frame);
         }
+        m_nbPeriods++;
 
         // add the last period time to the the total Measure Time
-        m_totalMeasureTime += m_periodTime;
+        m_totalMeasureTime.add(m_periodTime);
         
         // Calculation of the first point of the new period
-        deltaT = m_timerPeriod * (1. - czPoint);
+        deltaT = m_timerPeriod * (1.f - czPoint);
         m_tension.calcSample(deltaT, false);
-        for(Current &current : m_currents) {
-            current.calcSample(deltaT, false);
-        }
+        m_currents.calcPartialSample(tensionSample(), 1.f - czPoint);
+
+        // Close the resampled period and start the next one
+        resampleChrono.startCycle();
+        m_resampler.crossZero(data, czPoint);
+        resampleChrono.endCycle();
 
         // initialize current time with the first step of the new period
         m_periodTime = deltaT;
         
         // After 5 minutes, send the set of data through the UART and reset the data set
-        if (m_totalMeasureTime > MEASURE_PACKET_PERIOD) {
+        if (m_totalMeasureTime.get() > MEASURE_PACKET_PERIOD) {
             save();
-            m_totalMeasureTime = 0.;
+            m_totalMeasureTime.init();
         }
     }
     else {
         m_tension.calcSample(deltaT, false);
-        for(Current &current : m_currents) {
-            current.calcSample(deltaT, false);
-        }
+        m_currents.calcSample(tensionSample());
+        m_resampler.addSample(data);
         m_periodTime += m_timerPeriod;
         
-        if (m_periodTime > (1. / MIN_AC_FREQ)) {
-            errorManager.error(AC_FREQ_ERROR, "Measure", "Error on AC frequency calculation : " + std::to_string(1. / m_periodTime));
+        if (m_periodTime > (1.f / MIN_AC_FREQ)) {
+            errorManager.error(AC_FREQ_ERROR, MEASURE_SOURCE, "Error on AC frequency calculation", 1.f / m_periodTime);
         }
     }
 }
 
 
-std::string Measure::getJsonOld()
+/**
+ * @brief Write the measure data of the elapsed packet in a packet of the ring and restart the statistics
+ * 
+ * The packet is written in place, without allocation. If the ring is full and the packet
+ * is dropped, the statistics are restarted all the same.
+ */
+void Measure::save()
+{       
+    PROFILE_SCOPE(PROFILE_PACKET_SAVE);
+    Data* newData = m_packets.reserve();
+    if (newData != nullptr) {
+        fillData(*newData);
+        m_packets.commit();
+        if (logTaskHandle != nullptr) {
+            xTaskNotifyGive(logTaskHandle);
+        }
+    }
+    else {
+        HarmonicData harmonicData[NB_FFT_CHANNELS + 1];
+        harmonics.getData(harmonicData);
+    }
+
+    m_tension.resetStats();
+    m_currents.resetStats();
+}
+
+/**
+ * @brief Values of the elapsed period
+ */
+void Measure::fillPeriod(PeriodFrame &frame)
 {
-    cJSON_AddNumberToObject(m_data, "TotalMeasureTime(s)", m_totalMeasureTime);
-    cJSON_AddItemToObject(m_data, "Tension", m_tension.getJson());
+    frame.seq = m_nbPeriods;
+    frame.time = esp_timer_get_time();
+    frame.frequency = 1.f / m_periodTime;
+    frame.tensionRms = m_tension.getLastRms();
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        frame.currentRms[i] = m_currents.getLastRms(i);
+        frame.activePower[i] = m_currents.getLastPower(i);
+    }
+}
 
+void Measure::fillData(Measure::Data &data)
+{
+    data.timestamp = get_timestamp();
+    data.duration = m_totalMeasureTime.get();
+    data.tension = m_tension.getData();
     for (uint8_t i = 0; i < NB_CURRENTS; i++) {
-        cJSON_AddItemToObject(m_data, std::string("Current" + std::to_string(i)).c_str(), m_currents[i].getJson());
+        data.currents[i] = m_currents.getData(i);
     }
+    harmonics.getData(data.harmonics);
+    energyRegisters.read(data.energy);
+}
+
+
+void Measure::writeJsonFields(JsonWriter &writer, const Measure::Data &data)
+{
+    writer.addNumber("timestamp", data.timestamp);
+    writer.addNumber("duration", data.duration);
+    Tension::writeJson(writer, "tension", data.tension);
 
-    return std::string(cJSON_Print(m_data));
+    char key[16];
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        snprintf(key, sizeof(key), "current%u", i);
+        Current::writeJson(writer, key, data.currents[i]);
+    }
+
+    static const uint8_t fftCurrents[NB_FFT_CHANNELS] = FFT_CURRENT_IDS;
+    writer.beginObject("harmonics");
+    Harmonics::writeJson(writer, "tension", data.harmonics[0]);
+    for (uint8_t j = 0; j < NB_FFT_CHANNELS; j++) {
+        snprintf(key, sizeof(key), "current%u", fftCurrents[j]);
+        Harmonics::writeJson(writer, key, data.harmonics[j + 1]);
+    }
+    writer.endObject();
+
+    writer.beginObject("energyRegisters");
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        snprintf(key, sizeof(key), "current%u", i);
+        writer.beginObject(key);
+        writer.addNumber("Import(W.h)", EnergyRegisters::toWh(data.energy.importEnergy[i]));
+        writer.addNumber("Export(W.h)", EnergyRegisters::toWh(data.energy.exportEnergy[i]));
+        writer.endObject();
+    }
+    writer.endObject();
 }
 
 
 /**
- * @brief Save the measure data in a struct and push it into the FIFO
+ * @brief Copy a packet, from the ring if it is still buffered, else from the flash log
+ * 
+ * The ring lock is only held for the copy, so a reader never blocks the producer nor
+ * the other readers for a whole response.
  * 
+ * @param seq Sequence number of the packet
+ * @param data Packet (output)
+ * @return true if the packet exists
  */
-void Measure::save()
-{       
-    Data newData;
-    newData.timestamp = get_timestamp();
-    newData.duration = m_totalMeasureTime;
-    newData.tension = m_tension.getData();
-    uint8_t i = 0;
-    for (Current &current: m_currents) {
-        newData.currents[i] = current.getData();
-        i++;
-    }   
+bool Measure::getPacket(uint32_t seq, Measure::Data &data)
+{
+    if (m_packets.read((uint32_t)(seq - m_seqBase), data)) {
+        return true;
+    }
 
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    m_fifo.push(newData);
+    uint8_t record[PACKET_RECORD_SIZE];
+    if (!flashLog.read(seq, record)) {
+        return false;
+    }
+    decodeRecord(record, data);
+    return true;
 }
 
+/**
+ * @brief Sequence number of the oldest packet that may be read, in the ring or in the flash log
+ */
+uint32_t Measure::getFirstSeq()
+{
+    uint32_t firstSeq = m_seqBase + m_packets.getFirstSeq();
+    if (flashLog.isMounted() && flashLog.getFirstSeq() < flashLog.getNextSeq() && flashLog.getFirstSeq() < firstSeq) {
+        firstSeq = flashLog.getFirstSeq();
+    }
+    return firstSeq;
+}
 
-cJSON* Measure::serializeData(Measure::Data &data)
+/**
+ * @brief Acknowledge the packets up to a sequence number included, and release them from the ring
+ * 
+ * The acknowledged packets stay readable from the flash log until it wraps around.
+ * 
+ * @param seq Sequence number of the last packet received by the collector
+ */
+void Measure::ack(uint32_t seq)
 {
-    cJSON* jsonMeasure = cJSON_CreateObject();
-    cJSON_AddNumberToObject(jsonMeasure, "timestamp", data.timestamp);
-    cJSON_AddNumberToObject(jsonMeasure, "duration", data.duration);
-    cJSON_AddItemToObject(jsonMeasure, "tension", Tension::serializeData(data.tension));
+    uint32_t nextSeq = getNextSeq();
+    if (seq >= nextSeq) {
+        seq = nextSeq - 1;
+    }
+    uint32_t ackedSeq = m_ackedSeq.load();
+    while (seq + 1 > ackedSeq && !m_ackedSeq.compare_exchange_weak(ackedSeq, seq + 1)) {}
 
-    uint8_t i = 0;
-    for (Current::Data &current : data.currents) {
-        cJSON_AddItemToObject(jsonMeasure, std::string("current" + std::to_string(i)).c_str(), Current::serializeData(current));
-        i++;
-    }  
+    m_packets.releaseUntil((uint32_t)(seq - m_seqBase));
+}
+
+/**
+ * @brief Stream packets as a JSON array, from a sequence number, without releasing them
+ * 
+ * Each packet is copied, then formatted straight into the small buffer of the writer, so the
+ * memory used does not depend on the number of packets. Each object carries the "seq" of the
+ * packet: a collector resumes with the last one + 1, and acknowledges it with ack.
+ * 
+ * @param writer Writer bound to the output
+ * @param since Sequence number of the first packet (the oldest one if it is no longer available)
+ * @param limit Maximum number of packets to send
+ * @return size_t Number of packets sent
+ */
+size_t Measure::writeJson(JsonWriter &writer, uint32_t since, size_t limit)
+{
+    Data data;
+    uint32_t firstSeq = getFirstSeq();
+    uint32_t nextSeq = getNextSeq();
+    size_t nbSent = 0;
+
+    writer.beginArray();
+    for (uint32_t seq = (since > firstSeq) ? since : firstSeq; seq < nextSeq && nbSent < limit; seq++) {
+        if (!getPacket(seq, data)) {
+            continue;
+        }
+        {
+            PROFILE_SCOPE(PROFILE_SERIALIZATION);
+            writer.beginObject();
+            writer.addNumber("seq", seq);
+            writeJsonFields(writer, data);
+            writer.endObject();
+        }
+        if (!writer.flush()) {
+            break;
+        }
+        nbSent++;
+    }
+    writer.endArray();
+    writer.flush();
 
-    return jsonMeasure;
+    return nbSent;
 }
 
 
-bool Measure::popFromQueue(Measure::Data &data)
+static void encodeRange(RecordWriter &writer, const RangeData &data)
 {
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    if (!m_fifo.empty()) {
-        data = m_fifo.front();
-        m_fifo.pop();
-        return true;
+    writer.f32(data.min);
+    writer.f32(data.mean);
+    writer.f32(data.max);
+}
+
+/**
+ * @brief Encode a packet as a binary record (see packetRecord.h for the layout)
+ * 
+ * @param buffer Output, PACKET_RECORD_SIZE bytes
+ * @param seq Sequence number of the packet
+ * @param data Packet
+ */
+void Measure::encodeRecord(uint8_t* buffer, uint32_t seq, const Measure::Data &data)
+{
+    RecordWriter writer(buffer);
+    writer.u32(seq);
+    writer.i64(data.timestamp);
+    writer.f32(data.duration);
+
+    encodeRange(writer, data.tension.rms);
+    encodeRange(writer, data.tension.range);
+    encodeRange(writer, data.tension.freq);
+
+    for (const Current::Data &current : data.currents) {
+        encodeRange(writer, current.rms);
+        encodeRange(writer, current.range);
+        encodeRange(writer, current.activePower);
+        encodeRange(writer, current.apparentPower);
+        encodeRange(writer, current.reactivePower);
+        encodeRange(writer, current.powerFactor);
+        writer.f32(current.energy);
+    }
+
+    for (const HarmonicData &harmonic : data.harmonics) {
+        encodeRange(writer, harmonic.thd);
+        for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+            writer.f32(harmonic.harmonics[k]);
+        }
+    }
+
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        writer.u64(data.energy.importEnergy[i]);
+        writer.u64(data.energy.exportEnergy[i]);
     }
-    return false;
 }
 
+static RangeData decodeRange(RecordReader &reader)
+{
+    RangeData data;
+    data.min = reader.f32();
+    data.mean = reader.f32();
+    data.max = reader.f32();
+    return data;
+}
 
-std::string Measure::getJson()
+/**
+ * @brief Decode a binary record written by encodeRecord
+ * 
+ * @param buffer Record, PACKET_RECORD_SIZE bytes
+ * @param data Packet (output)
+ * @return uint32_t Sequence number of the packet
+ */
+uint32_t Measure::decodeRecord(const uint8_t* buffer, Measure::Data &data)
 {
+    RecordReader reader(buffer);
+    uint32_t seq = reader.u32();
+    data.timestamp = reader.i64();
+    data.duration = reader.f32();
 
-    Data data;
-    cJSON* jsonDataList = cJSON_CreateArray();
+    data.tension.rms = decodeRange(reader);
+    data.tension.range = decodeRange(reader);
+    data.tension.freq = decodeRange(reader);
+
+    for (Current::Data &current : data.currents) {
+        current.rms = decodeRange(reader);
+        current.range = decodeRange(reader);
+        current.activePower = decodeRange(reader);
+        current.apparentPower = decodeRange(reader);
+        current.reactivePower = decodeRange(reader);
+        current.powerFactor = decodeRange(reader);
+        current.energy = reader.f32();
+    }
 
-    while (popFromQueue(data)) {
-        cJSON* jsonData = serializeData(data);
-        cJSON_AddItemToArray(jsonDataList, jsonData);
+    for (HarmonicData &harmonic : data.harmonics) {
+        harmonic.thd = decodeRange(reader);
+        for (uint8_t k = 0; k < NB_HARMONICS; k++) {
+            harmonic.harmonics[k] = reader.f32();
+        }
+    }
+
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        data.energy.importEnergy[i] = reader.u64();
+        data.energy.exportEnergy[i] = reader.u64();
     }
 
-    std::string dataString(cJSON_Print(jsonDataList));
-    cJSON_Delete(jsonDataList);
+    return seq;
+}
+
+/**
+ * @brief Send a header and the binary records of packets, from a sequence number, without releasing them
+ * 
+ * The records carry their sequence number: a collector resumes with the last one + 1.
+ * 
+ * @param since Sequence number of the first packet (the oldest one if it is no longer available)
+ * @param limit Maximum number of packets to send
+ * @param sink Output of the bytes, returns false on failure
+ * @param ctx Context of the sink
+ * @return size_t Number of packets sent
+ */
+size_t Measure::writeBinary(uint32_t since, size_t limit, bool (*sink)(void* ctx, const uint8_t* data, size_t size), void* ctx)
+{
+    uint8_t buffer[PACKET_RECORD_SIZE];
+
+    PacketHeader header = {
+        PACKET_RECORD_MAGIC,
+        PACKET_RECORD_VERSION,
+        PACKET_HEADER_SIZE,
+        PACKET_RECORD_SIZE,
+        NB_CURRENTS,
+        NB_FFT_CHANNELS + 1,
+        NB_HARMONICS,
+        m_packets.getNbDropped()
+    };
+    header.encode(buffer);
+    if (!sink(ctx, buffer, PACKET_HEADER_SIZE)) {
+        return 0;
+    }
+
+    Data data;
+    uint32_t firstSeq = getFirstSeq();
+    uint32_t nextSeq = getNextSeq();
+    size_t nbSent = 0;
+
+    for (uint32_t seq = (since > firstSeq) ? since : firstSeq; seq < nextSeq && nbSent < limit; seq++) {
+        if (!getPacket(seq, data)) {
+            continue;
+        }
+        {
+            PROFILE_SCOPE(PROFILE_SERIALIZATION);
+            encodeRecord(buffer, seq, data);
+        }
+        if (!sink(ctx, buffer, PACKET_RECORD_SIZE)) {
+            break;
+        }
+        nbSent++;
+    }
 
-    return dataString;
+    return nbSent;
 }
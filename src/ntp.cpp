@@ -2,6 +2,9 @@
 #include "def.h"
 
 #include <esp_sntp.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdlib.h>
 #include <sys/time.h>
 #include <esp_log.h>
 
@@ -0,0 +1,44 @@
+#include "partitionFlash.h"
+
+
+PartitionFlash::PartitionFlash(const char* label) :
+    m_label(label),
+    m_partition(nullptr)
+{}
+
+/**
+ * @brief Find the partition in the partition table
+ *
+ * @return true if the partition exists
+ */
+bool PartitionFlash::begin()
+{
+    m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, m_label);
+    return m_partition != nullptr;
+}
+
+size_t PartitionFlash::getSize()
+{
+    return (m_partition != nullptr) ? m_partition->size : 0;
+}
+
+size_t PartitionFlash::getSectorSize()
+{
+    return (m_partition != nullptr) ? m_partition->erase_size : 0;
+}
+
+bool PartitionFlash::read(size_t offset, void* data, size_t size)
+{
+    return m_partition != nullptr && esp_partition_read(m_partition, offset, data, size) == ESP_OK;
+}
+
+bool PartitionFlash::write(size_t offset, const void* data, size_t size)
+{
+    return m_partition != nullptr && esp_partition_write(m_partition, offset, data, size) == ESP_OK;
+}
+
+bool PartitionFlash::eraseSector(size_t sector)
+{
+    size_t sectorSize = getSectorSize();
+    return m_partition != nullptr && esp_partition_erase_range(m_partition, sector * sectorSize, sectorSize) == ESP_OK;
+}
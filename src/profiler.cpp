@@ -0,0 +1,117 @@
+#include "profiler.h"
+
+#if PROFILING
+
+#include <math.h>
+#include <sdkconfig.h>
+
+Profiler profiler;
+
+
+void ProfileHistogram::init()
+{
+    for (std::atomic<uint32_t> &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max.store(0, std::memory_order_relaxed);
+}
+
+void ProfileHistogram::add(uint32_t cycles)
+{
+    buckets[getBucket(cycles)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t prevMax = max.load(std::memory_order_relaxed);
+    while (cycles > prevMax && !max.compare_exchange_weak(prevMax, cycles, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Bucket of a latency: the octave (most significant bit), then the next PROFILE_SUB_BUCKET_BITS bits
+ */
+uint8_t ProfileHistogram::getBucket(uint32_t cycles)
+{
+    if (cycles < (1u << PROFILE_SUB_BUCKET_BITS)) {
+        return cycles;
+    }
+    uint8_t msb = 31 - __builtin_clz(cycles);
+    uint8_t sub = (cycles >> (msb - PROFILE_SUB_BUCKET_BITS)) & ((1u << PROFILE_SUB_BUCKET_BITS) - 1);
+    return ((msb - PROFILE_SUB_BUCKET_BITS + 1) << PROFILE_SUB_BUCKET_BITS) | sub;
+}
+
+/**
+ * @brief Greatest latency of a bucket (the percentiles are rounded up to it)
+ */
+uint32_t ProfileHistogram::getUpperBound(uint8_t bucket)
+{
+    if (bucket < (1u << PROFILE_SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    uint8_t shift = (bucket >> PROFILE_SUB_BUCKET_BITS) - 1;
+    uint64_t lower = (uint64_t)((1u << PROFILE_SUB_BUCKET_BITS) | (bucket & ((1u << PROFILE_SUB_BUCKET_BITS) - 1))) << shift;
+    return lower + (1ull << shift) - 1;
+}
+
+
+Profiler::Profiler()
+{
+    for (ProfileHistogram &histogram : m_histograms) {
+        histogram.init();
+    }
+}
+
+const char* Profiler::getProbeName(ProfileProbe probe)
+{
+    static const char* names[NB_PROFILE_PROBES] = {"Acquisition", "Demux", "BlockDsp", "PeriodDsp", "PacketSave", "Serialization"};
+    return names[probe];
+}
+
+/**
+ * @brief Write the count, the percentiles (p50, p99, p999) and the maximum of each probe, in cycles and µs
+ *
+ * The buckets of a probe are copied first, so its percentiles are consistent with its count.
+ *
+ * @param writer Writer bound to the output
+ */
+void Profiler::writeJson(JsonWriter &writer)
+{
+    static const float quantiles[] = {0.5f, 0.99f, 0.999f};
+    static const char* cycleKeys[] = {"p50(cycles)", "p99(cycles)", "p999(cycles)"};
+    static const char* timeKeys[] = {"p50(µs)", "p99(µs)", "p999(µs)"};
+    const double cyclesPerUs = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    uint32_t buckets[PROFILE_NB_BUCKETS];
+
+    writer.beginObject();
+    writer.addNumber("CpuFrequency(MHz)", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    for (uint8_t probe = 0; probe < NB_PROFILE_PROBES; probe++) {
+        const ProfileHistogram &histogram = m_histograms[probe];
+        uint32_t count = 0;
+        for (uint8_t i = 0; i < PROFILE_NB_BUCKETS; i++) {
+            buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+            count += buckets[i];
+        }
+        uint32_t max = histogram.max.load(std::memory_order_relaxed);
+
+        writer.beginObject(getProbeName(static_cast<ProfileProbe>(probe)));
+        writer.addNumber("Count", count);
+        uint8_t bucket = 0;
+        uint32_t cumulated = 0;
+        for (uint8_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            // Rank of the quantile, rounded up
+            uint32_t rank = (uint32_t)ceilf(quantiles[q] * count);
+            while (bucket < PROFILE_NB_BUCKETS - 1 && cumulated + buckets[bucket] < rank) {
+                cumulated += buckets[bucket++];
+            }
+            uint32_t cycles = (count > 0) ? ProfileHistogram::getUpperBound(bucket) : 0;
+            cycles = (cycles < max) ? cycles : max;
+            writer.addNumber(cycleKeys[q], cycles);
+            writer.addNumber(timeKeys[q], cycles / cyclesPerUs);
+        }
+        writer.addNumber("max(cycles)", max);
+        writer.addNumber("max(µs)", max / cyclesPerUs);
+        writer.endObject();
+    }
+    writer.endObject();
+    writer.flush();
+}
+
+#endif      // PROFILING
@@ -0,0 +1,134 @@
+#include "resampler.h"
+
+#include "adc.h"
+
+// Nominal spacing of the output points, used until a first period has been measured
+#define NOMINAL_STEP    (1000000. / 50. / TIM_PERIOD / NB_SAMPLES)
+
+// Chrono to measure the closing of a resampled period, once per period (never per sample)
+Chrono resampleChrono("Resample", 20, (int)(1000 / ANALYZED_PERIOD), DEBUG);
+
+// Current channels analyzed
+static const uint8_t FFT_CURRENTS[NB_FFT_CHANNELS] = FFT_CURRENT_IDS;
+
+
+Resampler::Resampler() :
+    m_period(nullptr)
+{
+    init();
+}
+
+void Resampler::init()
+{
+    for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+        m_prev[i] = 0.f;
+        m_cur[i] = 0.f;
+    }
+    m_prevTime = 0.f;
+    m_nextTime = 0.f;
+    m_step = NOMINAL_STEP;
+    m_count = NB_SAMPLES;
+}
+
+/**
+ * @brief Shift the current sample of the analyzed channels and read the new one
+ *
+ * @param data Raw samples of all the ADC channels (the VREF channel is subtracted)
+ */
+void Resampler::readSample(const uint16_t* data)
+{
+    float vref = (float)data[VREF_ID];
+
+    for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+        m_prev[i] = m_cur[i];
+    }
+    m_cur[0] = (float)data[TENSION_ID] - vref;
+    for (uint8_t i = 0; i < NB_FFT_CHANNELS; i++) {
+        m_cur[i + 1] = (float)data[FFT_CURRENTS[i]] - vref;
+    }
+}
+
+/**
+ * @brief Write every output point due up to a given time, interpolated between the previous and the current sample
+ *
+ * @param time Time since the period start (timer periods), at most m_prevTime + 1
+ */
+void Resampler::emitUntil(float time)
+{
+    while (m_count < NB_SAMPLES && m_nextTime <= time) {
+        float frac = m_nextTime - m_prevTime;
+        if (m_period != nullptr) {
+            for (uint8_t i = 0; i <= NB_FFT_CHANNELS; i++) {
+                m_period->samples[i][m_count] = m_prev[i] + (m_cur[i] - m_prev[i]) * frac;
+            }
+        }
+        m_count++;
+        m_nextTime += m_step;
+    }
+}
+
+/**
+ * @brief Start the first period at a zero crossing
+ *
+ * The length of the previous period is not known yet, so this period is only
+ * measured: it is not handed to the harmonic analysis.
+ *
+ * @param data Raw samples of the first sample after the zero crossing
+ * @param czPoint Position of the zero crossing between the previous and the current sample
+ */
+void Resampler::startPeriod(const uint16_t* data, float czPoint)
+{
+    readSample(data);
+
+    m_period = nullptr;
+    m_count = 0;
+    m_prevTime = -czPoint;
+    m_nextTime = 0.f;
+    emitUntil(m_prevTime + 1.f);
+    m_prevTime += 1.f;
+}
+
+/**
+ * @brief Resample a sample inside a period
+ *
+ * @param data Raw samples of all the ADC channels
+ */
+void Resampler::addSample(const uint16_t* data)
+{
+    readSample(data);
+    emitUntil(m_prevTime + 1.f);
+    m_prevTime += 1.f;
+}
+
+/**
+ * @brief Close the period at a zero crossing and start the next one
+ *
+ * The points of a period shorter than expected are completed at the zero crossing,
+ * so that the period always holds NB_SAMPLES points. Its measured length gives the
+ * spacing of the points of the next period.
+ *
+ * @param data Raw samples of the first sample after the zero crossing
+ * @param czPoint Position of the zero crossing between the previous and the current sample
+ */
+void Resampler::crossZero(const uint16_t* data, float czPoint)
+{
+    readSample(data);
+
+    float crossingTime = m_prevTime + czPoint;
+    emitUntil(crossingTime);
+    while (m_count < NB_SAMPLES) {
+        m_nextTime = crossingTime;
+        emitUntil(crossingTime);
+    }
+    if (m_period != nullptr) {
+        harmonics.endPeriod();
+    }
+
+    m_step = crossingTime / NB_SAMPLES;
+    m_period = harmonics.beginPeriod();
+    m_count = 0;
+    m_prevTime = -czPoint;
+    m_nextTime = 0.f;
+    emitUntil(m_prevTime + 1.f);
+    m_prevTime += 1.f;
+}
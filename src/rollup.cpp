@@ -0,0 +1,217 @@
+#include "rollup.h"
+#include "errorManager.h"
+#include "ntp.h"
+
+#include <string.h>
+
+Rollup rollup;
+
+
+void Aggregate::init()
+{
+    timestamp = 0;
+    nbPeriods = 0;
+    tensionRms.init();
+    frequency.init();
+    currents.init();
+}
+
+/**
+ * @brief Add the values of a period (S, Q and PF are derived as in the packet statistics)
+ *
+ * @param frame Values of the elapsed period
+ */
+void Aggregate::addPeriod(const PeriodFrame &frame)
+{
+    float dt = 1.f / frame.frequency;
+
+    nbPeriods++;
+    tensionRms.update(0, frame.tensionRms, dt);
+    frequency.update(0, frame.frequency, dt);
+    currents.addPeriod(dt);
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        currents.update(i, frame.currentRms[i], frame.activePower[i], frame.tensionRms, dt);
+    }
+}
+
+/**
+ * @brief Merge the statistics of another window (associative: the grouping of the merges does not matter)
+ */
+void Aggregate::merge(const Aggregate &other)
+{
+    timestamp = (other.timestamp > timestamp) ? other.timestamp : timestamp;
+    nbPeriods += other.nbPeriods;
+    tensionRms.merge(other.tensionRms);
+    frequency.merge(other.frequency);
+    currents.merge(other.currents);
+}
+
+
+Rollup::Rollup() :
+    m_secondTime(0.f)
+{}
+
+/**
+ * @brief Allocate the rings of the tiers, once at startup, so that the DSP task never allocates
+ *
+ * @return true if all the rings are allocated (otherwise the windows of a tier are dropped)
+ */
+bool Rollup::begin()
+{
+    if (!m_seconds.ring.allocate() || !m_minutes.ring.allocate() || !m_fiveMinutes.ring.allocate() || !m_hours.ring.allocate()) {
+        size_t nbWindows = ROLLUP_1S_RING_SIZE + ROLLUP_1M_RING_SIZE + ROLLUP_5M_RING_SIZE + ROLLUP_1H_RING_SIZE;
+        errorManager.error(INIT_ERROR, ROLLUP_SOURCE, "Error on rollup ring allocation (bytes)", nbWindows * sizeof(Aggregate));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a period to the open second, and close the windows that are complete (DSP task)
+ *
+ * The seconds follow the measure time: they last 1 s on average, to a period.
+ *
+ * @param frame Values of the elapsed period
+ */
+void Rollup::addPeriod(const PeriodFrame &frame)
+{
+    m_seconds.open.addPeriod(frame);
+    m_secondTime += 1.f / frame.frequency;
+    if (m_secondTime < 1.f) {
+        return;
+    }
+    m_secondTime -= 1.f;
+
+    m_seconds.open.timestamp = get_timestamp();
+    close(m_seconds, &m_minutes.open);
+    if (++m_minutes.nbMerged < ROLLUP_SECONDS_PER_MINUTE) {
+        return;
+    }
+    close(m_minutes, &m_fiveMinutes.open);
+    if (++m_fiveMinutes.nbMerged < ROLLUP_MINUTES_PER_5MIN) {
+        return;
+    }
+    close(m_fiveMinutes, &m_hours.open);
+    if (++m_hours.nbMerged < ROLLUP_5MIN_PER_HOUR) {
+        return;
+    }
+    close(m_hours, nullptr);
+}
+
+/**
+ * @brief Store the open window of a tier in its ring, merge it into the open window of the next tier, and restart it
+ */
+template <size_t N>
+void Rollup::close(Tier<N> &tier, Aggregate* next)
+{
+    Aggregate* slot = tier.ring.reserve();
+    if (slot != nullptr) {
+        *slot = tier.open;
+        tier.ring.commit();
+    }
+    if (next != nullptr) {
+        next->merge(tier.open);
+    }
+    tier.open.init();
+    tier.nbMerged = 0;
+}
+
+bool Rollup::parseResolution(const char* name, Rollup::Resolution &resolution)
+{
+    static const char* names[] = {"1s", "1m", "5m", "1h"};
+    for (uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            resolution = static_cast<Resolution>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Rollup::getBytes()
+{
+    return m_seconds.ring.getBytes() + m_minutes.ring.getBytes() + m_fiveMinutes.ring.getBytes() + m_hours.ring.getBytes();
+}
+
+
+void Rollup::writeJson(JsonWriter &writer, uint32_t seq, const Aggregate &aggregate)
+{
+    float duration = aggregate.getDuration();
+    const PowerStats<NB_CURRENTS> &currents = aggregate.currents;
+
+    writer.beginObject();
+    writer.addNumber("seq", seq);
+    writer.addNumber("timestamp", aggregate.timestamp);
+    writer.addNumber("duration", duration);
+    writer.addNumber("periods", aggregate.nbPeriods);
+
+    writer.beginObject("tension");
+    Signal::writeJson(writer, "RMS(V)", aggregate.tensionRms.get(0, duration));
+    Signal::writeJson(writer, "frequency(Hz)", aggregate.frequency.get(0, duration));
+    writer.endObject();
+
+    char key[16];
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        snprintf(key, sizeof(key), "current%u", i);
+        writer.beginObject(key);
+        Signal::writeJson(writer, "RMS(A)", currents.rms.get(i, duration));
+        Signal::writeJson(writer, "ActivePower(W)", currents.activePower.get(i, duration));
+        Signal::writeJson(writer, "ApparentPower(VA)", currents.apparentPower.get(i, duration));
+        Signal::writeJson(writer, "ReactivePower(var)", currents.reactivePower.get(i, duration));
+        Signal::writeJson(writer, "PowerFactor", currents.powerFactor.get(i, duration));
+        writer.addNumber("Energy(W.h)", currents.energy[i].get());
+        writer.endObject();
+    }
+    writer.endObject();
+}
+
+template <size_t N>
+size_t Rollup::writeTier(JsonWriter &writer, Tier<N> &tier, uint32_t since, size_t limit)
+{
+    Aggregate aggregate;
+    size_t firstSeq = tier.ring.getFirstSeq();
+    size_t nextSeq = tier.ring.getNextSeq();
+    size_t nbSent = 0;
+
+    writer.beginArray();
+    for (size_t seq = (since > firstSeq) ? since : firstSeq; seq < nextSeq && nbSent < limit; seq++) {
+        if (!tier.ring.read(seq, aggregate)) {
+            continue;
+        }
+        writeJson(writer, seq, aggregate);
+        if (!writer.flush()) {
+            break;
+        }
+        nbSent++;
+    }
+    writer.endArray();
+    writer.flush();
+
+    return nbSent;
+}
+
+/**
+ * @brief Stream the closed windows of a tier as a JSON array, from a sequence number of the tier
+ *
+ * The windows are copied one by one, so the DSP task is never held by a reader.
+ *
+ * @param writer Writer bound to the output
+ * @param resolution Tier
+ * @param since Sequence number of the first window (the oldest one if it is no longer buffered)
+ * @param limit Maximum number of windows to send
+ * @return size_t Number of windows sent
+ */
+size_t Rollup::writeJson(JsonWriter &writer, Rollup::Resolution resolution, uint32_t since, size_t limit)
+{
+    switch (resolution) {
+        case SECOND:
+            return writeTier(writer, m_seconds, since, limit);
+        case MINUTE:
+            return writeTier(writer, m_minutes, since, limit);
+        case FIVE_MINUTES:
+            return writeTier(writer, m_fiveMinutes, since, limit);
+        default:
+        case HOUR:
+            return writeTier(writer, m_hours, since, limit);
+    }
+}
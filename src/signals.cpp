@@ -2,7 +2,6 @@
 
 #include "signals.h"
 #include "def.h"
-#include "adc.h"
 #include "errorManager.h"
 
 
@@ -13,15 +12,35 @@ Rms::Rms()
 
 void Rms::init()
 {
-    m_max = -999999.;
-    m_mean = 0.;
-    m_min = 999999.;
+    m_max = -999999.f;
+    m_mean.init();
+    m_min = 999999.f;
+    m_temp = 0.f;
+    m_last = 0.f;
 }
 
-void Rms::save(float periodTime, float totalMeasureTime)
+/**
+ * @brief Restart the min, max and mean statistics, keeping the period being accumulated
+ */
+void Rms::resetStats()
 {
-    float rmsVal = pow(m_temp / periodTime, 0.5);
-    m_temp = 0.;
+    m_max = -999999.f;
+    m_mean.init();
+    m_min = 999999.f;
+}
+
+/**
+ * @brief Compute the RMS value of the elapsed period and update the statistics
+ * 
+ * The square root is only computed here, once per period, and the mean is only divided when it is read.
+ * 
+ * @param periodTime Duration of the elapsed period (s)
+ */
+void Rms::save(float periodTime)
+{
+    float rmsVal = sqrtf(m_temp / periodTime);
+    m_temp = 0.f;
+    m_last = rmsVal;
 
     if (rmsVal < m_min) {
         m_min = rmsVal;
@@ -30,21 +49,16 @@ void Rms::save(float periodTime, float totalMeasureTime)
         m_max = rmsVal;
     }
 
-    m_mean = (m_mean * totalMeasureTime + rmsVal * periodTime) / (totalMeasureTime + periodTime);
-}
-
-void Rms::update(float val, float deltaT)
-{
-    m_temp += pow(val, 2) * deltaT;
+    m_mean.add(rmsVal, periodTime);
 }
 
 
-cJSON* Rms::getJson()
+cJSON* Rms::getJson(float duration)
 {
     cJSON* data = cJSON_CreateObject();
 
     cJSON_AddNumberToObject(data, "min", m_min);
-    cJSON_AddNumberToObject(data, "mean", m_mean);
+    cJSON_AddNumberToObject(data, "mean", m_mean.get(duration));
     cJSON_AddNumberToObject(data, "max", m_max);
 
     return data;
@@ -53,8 +67,6 @@ cJSON* Rms::getJson()
 
 
 Signal::Signal() :
-    m_buffer(NB_SAMPLES),
-    m_iBuffer(0),
     m_adcChannel(0),
     m_calibCoeffA(0),
     m_calibCoeffB(0)
@@ -64,29 +76,45 @@ Signal::Signal() :
 void Signal::setChannelId(uint8_t adcChannel)
 {
     m_adcChannel = adcChannel;
-    m_calibCoeffA = CALIB_A_COEFFS[adcChannel];
-    m_calibCoeffB = CALIB_B_COEFFS[adcChannel];
+    m_calibCoeffA = ActiveLayout::calibA[adcChannel];
+    m_calibCoeffB = ActiveLayout::calibB[adcChannel];
 }
 
 void Signal::init()
 {
     m_val = 0.;
     m_prevVal = 0.;
+    m_rawVal = 0;
     m_maxVal = -999999;
     m_minVal = 999999.;
     m_rms.init();
 }
 
+/**
+ * @brief Restart the statistics of a packet, keeping the period being accumulated
+ */
+void Signal::resetStats()
+{
+    m_maxVal = -999999;
+    m_minVal = 999999.;
+    m_rms.resetStats();
+}
+
 void Signal::setVal(float val)
 {
     m_prevVal = m_val;
     m_val = val;
+}
 
-    m_buffer[m_iBuffer] = val;
-    m_iBuffer++;
-    if (m_iBuffer == NB_SAMPLES) {
-        m_iBuffer = 0;
-    }
+/**
+ * @brief Set the value of the signal from a set of raw ADC samples
+ * 
+ * @param data Raw samples of all the ADC channels (the VREF channel is subtracted)
+ */
+void Signal::setRawVal(const uint16_t* data)
+{
+    m_rawVal = (int32_t)data[m_adcChannel] - (int32_t)data[VREF_ID];
+    setVal(m_calibCoeffA * (float)m_rawVal + m_calibCoeffB);
 }
 
 cJSON* Signal::getJson()
@@ -100,14 +128,13 @@ cJSON* Signal::getJson()
 }
 
 
-cJSON* Signal::serializeData(RangeData &data)
+void Signal::writeJson(JsonWriter &writer, const char* key, const RangeData &data)
 {
-    cJSON* jsonData = cJSON_CreateObject();
-    cJSON_AddNumberToObject(jsonData, "min", data.min);
-    cJSON_AddNumberToObject(jsonData, "mean", data.mean);
-    cJSON_AddNumberToObject(jsonData, "max", data.max);
-
-    return jsonData;
+    writer.beginObject(key);
+    writer.addNumber("min", data.min);
+    writer.addNumber("mean", data.mean);
+    writer.addNumber("max", data.max);
+    writer.endObject();
 }
 
 
@@ -120,22 +147,38 @@ Tension::Tension()
 void Tension::init()
 {
     Signal::init();
-    m_freqMean = 0.;
+    m_time.init();
+    m_freqMean.init();
+    m_freqMin = 999999.;
+    m_freqMax = 0.;
+}
+
+void Tension::resetStats()
+{
+    Signal::resetStats();
+    m_time.init();
+    m_freqMean.init();
     m_freqMin = 999999.;
     m_freqMax = 0.;
 }
 
-void Tension::calcPeriod(float periodTime, float totalMeasureTime)
+/**
+ * @brief Update the frequency and RMS statistics with the elapsed period
+ * 
+ * @param periodTime Duration of the elapsed period (s)
+ */
+void Tension::calcPeriod(float periodTime)
 {
-    float freq = 1. / periodTime;
+    float freq = 1.f / periodTime;
     if (freq < m_freqMin) {
         m_freqMin = freq;
     }
     if (freq > m_freqMax) {
         m_freqMax = freq;
     }
-    m_freqMean = (m_freqMean * totalMeasureTime + freq * periodTime) / (totalMeasureTime + periodTime);
-    m_rms.save(periodTime, totalMeasureTime);
+    m_freqMean.add(freq, periodTime);
+    m_time.add(periodTime);
+    m_rms.save(periodTime);
 }
 
 bool Tension::isCrossingZero(float* czPoint)
@@ -147,7 +190,7 @@ bool Tension::isCrossingZero(float* czPoint)
         *czPoint = -b / a;
 
         if (*czPoint > 1 || *czPoint < 0) {
-            errorManager.error(IMPOSSIBLE_VALUE_ERROR, "Tension", "Error on crossing-zero point : " + std::to_string(*czPoint ));
+            errorManager.error(IMPOSSIBLE_VALUE_ERROR, TENSION_SOURCE, "Error on crossing-zero point", *czPoint);
         }
 
         return true;
@@ -174,82 +217,39 @@ cJSON* Tension::getJson()
 {    
     cJSON* freqData = cJSON_CreateObject();
     cJSON_AddNumberToObject(freqData, "min", m_freqMin);
-    cJSON_AddNumberToObject(freqData, "mean", m_freqMean);
+    cJSON_AddNumberToObject(freqData, "mean", m_freqMean.get(m_time.get()));
     cJSON_AddNumberToObject(freqData, "max", m_freqMax);
 
     cJSON* data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "RMS(V)", m_rms.getJson());
+    cJSON_AddItemToObject(data, "RMS(V)", m_rms.getJson(m_time.get()));
     cJSON_AddItemToObject(data, "range(V)", Signal::getJson());
     cJSON_AddItemToObject(data, "frequency(Hz)", freqData);
 
     return data;
 }
 
-cJSON* Tension::serializeData(Tension::Data &data)
+void Tension::writeJson(JsonWriter &writer, const char* key, const Tension::Data &data)
 {
-    cJSON* jsonData = cJSON_CreateObject();
-    cJSON_AddItemToObject(jsonData, "RMS(V)", Signal::serializeData(data.rms));
-    cJSON_AddItemToObject(jsonData, "range(V)", Signal::serializeData(data.range));
-    cJSON_AddItemToObject(jsonData, "frequency(Hz)", Signal::serializeData(data.freq));
-
-    return jsonData;
+    writer.beginObject(key);
+    Signal::writeJson(writer, "RMS(V)", data.rms);
+    Signal::writeJson(writer, "range(V)", data.range);
+    Signal::writeJson(writer, "frequency(Hz)", data.freq);
+    writer.endObject();
 }
 
 
 
 
 
-Current::Current()
+void Current::writeJson(JsonWriter &writer, const char* key, const Current::Data &data)
 {
-    init();
-}
-
-void Current::init()
-{
-    Signal::init();
-    m_energy = 0.;
-}
-
-void Current::calcSample(float deltaT, bool lastSample)
-{
-    m_prevVal = m_val;
-    m_val = m_calibCoeffA * ((float)adcValues[m_adcChannel] - (float)adcValues[VREF_ID]) + m_calibCoeffB;
-    float I = m_val;
-
-    if (lastSample) {
-        // If the calculation is the last sample, then make a linear interpolation to get the current corresponding to deltaT
-        I = m_prevVal + (m_val - m_prevVal) * deltaT;
-        // For the last sample, energy is not updated since U is considered as nul
-    }
-    else {
-        m_energy += m_val * I * TIM_PERIOD / 3600;      // The energy is in Wh
-    }
-
-    if (m_val > m_maxVal) {
-        m_maxVal = m_val;
-    }
-    else if (m_val < m_minVal) {
-        m_minVal = m_val;
-    }
-    m_rms.update(I, deltaT);
-}
-
-cJSON* Current::getJson()
-{
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "RMS(A)", m_rms.getJson());
-    cJSON_AddItemToObject(data, "Range(A)", Signal::getJson());
-    cJSON_AddNumberToObject(data, "Energy(W.h)", m_energy);
-
-    return data;
-}
-
-cJSON* Current::serializeData(Current::Data &data)
-{
-    cJSON* jsonData = cJSON_CreateObject();
-    cJSON_AddItemToObject(jsonData, "RMS(A)", Signal::serializeData(data.rms));
-    cJSON_AddItemToObject(jsonData, "Range(A)", Signal::serializeData(data.range));
-    cJSON_AddNumberToObject(jsonData, "Energy(W.h)", data.energy);
-
-    return jsonData;
+    writer.beginObject(key);
+    Signal::writeJson(writer, "RMS(A)", data.rms);
+    Signal::writeJson(writer, "Range(A)", data.range);
+    Signal::writeJson(writer, "ActivePower(W)", data.activePower);
+    Signal::writeJson(writer, "ApparentPower(VA)", data.apparentPower);
+    Signal::writeJson(writer, "ReactivePower(var)", data.reactivePower);
+    Signal::writeJson(writer, "PowerFactor", data.powerFactor);
+    writer.addNumber("Energy(W.h)", data.energy);
+    writer.endObject();
 }
@@ -0,0 +1,103 @@
+#include "snapshot.h"
+#include "errorManager.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+Snapshot::Snapshot(Snapshot::VersionFunction version, Snapshot::RenderFunction render, void* ctx) :
+    m_version(version),
+    m_render(render),
+    m_ctx(ctx),
+    m_size(0),
+    m_valid(false),
+    m_renderVersion(0)
+{
+    m_etag[0] = '\0';
+}
+
+/**
+ * @brief Serve the snapshot, rendered again first if the source has a new version
+ *
+ * The bytes are copied to the stack of the caller before they are sent, so that a slow
+ * client does not hold the snapshot.
+ *
+ * @param req HTTP request
+ * @return esp_err_t ESP_OK if the response is sent
+ */
+esp_err_t Snapshot::serve(httpd_req_t *req)
+{
+    char match[SNAPSHOT_MATCH_SIZE] = "";
+    size_t matchLength = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (matchLength > 0 && matchLength < sizeof(match)) {
+        httpd_req_get_hdr_value_str(req, "If-None-Match", match, sizeof(match));
+    }
+
+    char data[SNAPSHOT_SIZE];
+    char etag[SNAPSHOT_ETAG_SIZE];
+    size_t size;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        update();
+        if (!m_valid) {
+            return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Snapshot too large");
+        }
+        memcpy(etag, m_etag, sizeof(etag));
+        size = m_size;
+        if (strcmp(match, "*") != 0 && strstr(match, etag) == nullptr) {
+            memcpy(data, m_data, size);
+        }
+        else {
+            size = 0;
+        }
+    }
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (size == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, data, size);
+}
+
+/**
+ * @brief Render the snapshot again if the version of the source changed (locked)
+ *
+ * The ETag is the FNV-1a hash of the bytes: it only changes with the content.
+ */
+void Snapshot::update()
+{
+    uint32_t version = m_version(m_ctx);
+    if (m_valid && version == m_renderVersion) {
+        return;
+    }
+
+    m_size = 0;
+    JsonWriter writer(append, this);
+    m_render(writer, m_ctx);
+    m_valid = writer.flush();
+    m_renderVersion = version;
+    if (!m_valid) {
+        errorManager.error(GENERIC_ERROR, HTTP_SOURCE, "Snapshot larger than its buffer (bytes)", SNAPSHOT_SIZE);
+        return;
+    }
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < m_size; i++) {
+        hash = (hash ^ (uint8_t)m_data[i]) * 16777619u;
+    }
+    snprintf(m_etag, sizeof(m_etag), "\"%08lx\"", (unsigned long)hash);
+}
+
+bool Snapshot::append(void* ctx, const char* data, size_t size)
+{
+    Snapshot* snapshot = static_cast<Snapshot*>(ctx);
+    if (snapshot->m_size + size > SNAPSHOT_SIZE) {
+        return false;
+    }
+    memcpy(snapshot->m_data + snapshot->m_size, data, size);
+    snapshot->m_size += size;
+    return true;
+}
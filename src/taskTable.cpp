@@ -0,0 +1,69 @@
+#include "taskTable.h"
+#include "adc.h"
+#include "harmonics.h"
+#include "flashLog.h"
+#include "liveStream.h"
+#include "httpHandler.h"
+#include "errorManager.h"
+
+#include <sdkconfig.h>
+
+static TaskHandle_t adcTaskHandle = nullptr;
+
+static_assert(HTTP_NB_WORKERS == 2, "One HTTP worker row per worker in the task table");
+
+// Placement of the pipeline stages. The DSP task is alone on DSP_CORE, so that the network and
+// the storage never delay the sampling path; the acquisition shares SYSTEM_CORE with them, above
+// them except for the Wi-Fi and TCP/IP tasks (pinned in sdkconfig, 0: set by the component), and
+// the driver pool absorbs their bursts. Each stage waits for a notification from the previous
+// one: no task polls. The consumers are listed (and started) before their producers.
+static const TaskPlacement taskTable[NB_TASKS] = {
+    // name             function        handle                  stack   prio    core            input               depth
+    {"Log Task",        log_task,       &logTaskHandle,         4096,   1,      SYSTEM_CORE,    "Packet ring",      PACKET_RING_SIZE},
+    {"Stream Task",     stream_task,    &streamTaskHandle,      4096,   2,      SYSTEM_CORE,    "Period ring",      LIVE_STREAM_RING_SIZE},
+    {"Harmonic Task",   harmonic_task,  &harmonicTaskHandle,    4096,   3,      SYSTEM_CORE,    "Resampled ring",   PERIOD_RING_SIZE},
+    {"DSP Task",        dsp_task,       &dspTaskHandle,         4096,   5,      DSP_CORE,       "ADC block ring",   ADC_RING_SIZE},
+    {"ADC Task",        adc_task,       &adcTaskHandle,         4096,   5,      SYSTEM_CORE,    "DMA pool",         DMA_BUFFER_SIZE / ADC_FRAME_SIZE},
+    {"httpd",           nullptr,        nullptr,                4096,   4,      SYSTEM_CORE,    "Sockets",          13},
+    {"HTTP Worker 0",   http_worker_task, &httpWorkerHandles[0], 8192, 2,      SYSTEM_CORE,    "Request queue",    HTTP_QUEUE_DEPTH},
+    {"HTTP Worker 1",   http_worker_task, &httpWorkerHandles[1], 8192, 2,      SYSTEM_CORE,    "Request queue",    HTTP_QUEUE_DEPTH},
+    {"wifi",            nullptr,        nullptr,                0,      0,      SYSTEM_CORE,    nullptr,            0},
+    {"tcpip_thread",    nullptr,        nullptr,                CONFIG_LWIP_TCPIP_TASK_STACK_SIZE, 0, SYSTEM_CORE, "TCP/IP mailbox", CONFIG_LWIP_TCPIP_RECVMBOX_SIZE},
+};
+
+
+/**
+ * @brief Create the tasks of the table that have a function, pinned to their core
+ *
+ * @return true if every task is created
+ */
+bool tasks_start()
+{
+    bool ok = true;
+    for (const TaskPlacement &task : taskTable) {
+        if (task.function == nullptr) {
+            continue;
+        }
+        if (xTaskCreatePinnedToCore(task.function, task.name, task.stackSize, NULL, task.priority, task.handle, task.core) != pdPASS) {
+            errorManager.error(INIT_ERROR, TASKS_SOURCE, "Error on task creation (stack bytes)", task.stackSize);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+const TaskPlacement& tasks_get(TaskId id)
+{
+    return taskTable[id];
+}
+
+/**
+ * @brief Handle of a task, looked up by name for the tasks of the IDF components
+ *
+ * @return TaskHandle_t nullptr if the task does not run
+ */
+TaskHandle_t tasks_getHandle(TaskId id)
+{
+    const TaskPlacement &task = taskTable[id];
+    return (task.handle != nullptr) ? *task.handle : xTaskGetHandle(task.name);
+}
@@ -1,12 +1,25 @@
 #include "wifi.h"
 #include "adc.h"
 #include "measure.h"
+#include "resampler.h"
+#include "flashLog.h"
+#include "liveStream.h"
+#include "rollup.h"
+#include "energyRegisters.h"
+#include "errorManager.h"
+#include "profiler.h"
+#include "deadlineMonitor.h"
+#include "taskTable.h"
+#include "httpHandler.h"
+#include "snapshot.h"
 #include "ntp.h"
 
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <unistd.h>
 
 
 // Variable volatile utilisée pour déclencher des actions en réponse aux requêtes HTTP
@@ -14,21 +27,259 @@ static volatile bool actionFlag = false;
 
 
 
+/**
+ * @brief Lit un paramètre entier de la query string d'une requête.
+ * 
+ * @param req La requête HTTP reçue.
+ * @param key Le nom du paramètre.
+ * @param defaultVal La valeur retournée si le paramètre est absent ou invalide.
+ * @return size_t La valeur du paramètre.
+ */
+static size_t get_query_param(httpd_req_t *req, const char* key, size_t defaultVal) {
+    char query[64];
+    char value[16];
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK
+        || httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return defaultVal;
+    }
+
+    char* end;
+    unsigned long val = strtoul(value, &end, 10);
+    return (end != value && *end == '\0') ? val : defaultVal;
+}
+
+/**
+ * @brief Lit un paramètre texte de la query string d'une requête.
+ * 
+ * @param req La requête HTTP reçue.
+ * @param key Le nom du paramètre.
+ * @param value Le tampon de sortie.
+ * @param size La taille du tampon.
+ * @return true si le paramètre est présent.
+ */
+static bool get_query_string(httpd_req_t *req, const char* key, char* value, size_t size) {
+    char query[64];
+
+    return httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+        && httpd_query_key_value(query, key, value, size) == ESP_OK;
+}
+
+/**
+ * @brief Envoie un morceau de la réponse HTTP en cours (sink du JsonWriter).
+ * 
+ * @param ctx La requête HTTP en cours.
+ * @return true si le morceau a été envoyé.
+ */
+static bool send_chunk(void* ctx, const char* data, size_t size) {
+    return httpd_resp_send_chunk(static_cast<httpd_req_t*>(ctx), data, size) == ESP_OK;
+}
+
 /**
  * @brief Handler pour obtenir les données ADC via une requête HTTP GET.
  * 
- * Cette fonction lit les valeurs ADC et les retourne en tant que réponse JSON.
+ * Cette fonction envoie les paquets de mesure sous forme de tableau JSON compact, morceau
+ * par morceau, sans les retirer : la mémoire utilisée ne dépend pas du nombre de paquets.
+ * Paramètres : since, numéro de séquence du premier paquet (par défaut le premier paquet
+ * non acquitté), et limit, nombre maximal de paquets. Les paquets qui ne sont plus dans le
+ * ring sont lus dans le journal en flash. Avec le paramètre resolution (1s, 1m, 5m ou 1h),
+ * les fenêtres agrégées de ce niveau sont envoyées à la place des paquets, depuis la plus
+ * ancienne par défaut.
  * @param req La requête HTTP reçue.
  * @return esp_err_t ESP_OK si la requête est traitée avec succès.
  */
 static esp_err_t get_adc_data_handler(httpd_req_t *req) {
-    std::string json_string = measure.getJson();
+    size_t limit = get_query_param(req, "limit", PACKET_RING_SIZE);
+    char resolutionName[8];
+    Rollup::Resolution resolution;
+    bool rolledUp = get_query_string(req, "resolution", resolutionName, sizeof(resolutionName));
+    if (rolledUp && !Rollup::parseResolution(resolutionName, resolution)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown resolution");
+    }
+
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string.c_str(), json_string.length());
+
+    JsonWriter writer(send_chunk, req);
+    if (rolledUp) {
+        rollup.writeJson(writer, resolution, get_query_param(req, "since", 0), limit);
+    }
+    else {
+        measure.writeJson(writer, get_query_param(req, "since", measure.getAckedSeq()), limit);
+    }
+    if (!writer.isOk()) {
+        return ESP_FAIL;
+    }
+    
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief Envoie un morceau binaire de la réponse HTTP en cours.
+ * 
+ * @param ctx La requête HTTP en cours.
+ * @return true si le morceau a été envoyé.
+ */
+static bool send_binary_chunk(void* ctx, const uint8_t* data, size_t size) {
+    return httpd_resp_send_chunk(static_cast<httpd_req_t*>(ctx), reinterpret_cast<const char*>(data), size) == ESP_OK;
+}
+
+/**
+ * @brief Handler pour obtenir les données ADC au format binaire via une requête HTTP GET.
+ * 
+ * Cette fonction envoie un en-tête puis les paquets sous forme d'enregistrements de taille
+ * fixe (voir packetRecord.h), sans les retirer. Paramètres : since, numéro de séquence du
+ * premier paquet (par défaut le premier paquet non acquitté), et limit, nombre maximal de paquets.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_adc_data_bin_handler(httpd_req_t *req) {
+    uint32_t since = get_query_param(req, "since", measure.getAckedSeq());
+    size_t limit = get_query_param(req, "limit", PACKET_RING_SIZE);
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    measure.writeBinary(since, limit, send_binary_chunk, req);
     
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief Handler pour obtenir les registres d'énergie via une requête HTTP GET.
+ * 
+ * Cette fonction retourne les énergies importée et exportée de chaque voie depuis la mise
+ * en service : l'énergie d'un intervalle est la différence de deux lectures. La réponse
+ * est formatée dans le tampon du JsonWriter, sans allocation.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_energy_handler(httpd_req_t *req) {
+    EnergyRegisters::Values values;
+    energyRegisters.read(values);
+
+    httpd_resp_set_type(req, "application/json");
+
+    JsonWriter writer(send_chunk, req);
+    char key[16];
+    writer.beginObject();
+    writer.addNumber("timestamp", get_timestamp());
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        snprintf(key, sizeof(key), "current%u", i);
+        writer.beginObject(key);
+        writer.addNumber("Import(W.h)", EnergyRegisters::toWh(values.importEnergy[i]));
+        writer.addNumber("Export(W.h)", EnergyRegisters::toWh(values.exportEnergy[i]));
+        writer.endObject();
+    }
+    writer.addBool("Restored", energyRegisters.isRestored());
+    writer.addNumber("Checkpoints", energyRegisters.getNbCheckpoints());
+    writer.addNumber("CheckpointErrors", energyRegisters.getNbCheckpointErrors());
+    writer.endObject();
+    writer.flush();
+    if (!writer.isOk()) {
+        return ESP_FAIL;
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief Handler pour obtenir les erreurs via une requête HTTP GET.
+ * 
+ * Cette fonction envoie les compteurs de chaque code d'erreur, puis les dernières erreurs
+ * enregistrées, par pages. Paramètres : since, numéro de séquence de la première erreur (par
+ * défaut la plus ancienne encore en mémoire ; NextSeq donne la page suivante), et limit,
+ * nombre maximal d'erreurs.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_errors_handler(httpd_req_t *req) {
+    uint32_t since = get_query_param(req, "since", 0);
+    size_t limit = get_query_param(req, "limit", ERROR_RING_SIZE);
+
+    httpd_resp_set_type(req, "application/json");
+
+    JsonWriter writer(send_chunk, req);
+    errorManager.writeJson(writer, since, limit);
+    if (!writer.isOk()) {
+        return ESP_FAIL;
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+#if PROFILING
+/**
+ * @brief Handler pour obtenir les latences des étapes du traitement via une requête HTTP GET.
+ * 
+ * Cette fonction retourne, pour chaque sonde (acquisition, démultiplexage, DSP par échantillon
+ * et par période, sauvegarde des paquets, sérialisation), le nombre de mesures et les
+ * percentiles p50, p99 et p999 en cycles CPU et en µs. Disponible seulement si PROFILING.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_profile_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+
+    JsonWriter writer(send_chunk, req);
+    profiler.writeJson(writer);
+    if (!writer.isOk()) {
+        return ESP_FAIL;
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+#endif
+
+/**
+ * @brief Handler pour acquitter les paquets reçus via une requête HTTP POST.
+ * 
+ * Cette fonction libère du ring les paquets jusqu'au numéro de séquence seq inclus : ils ne
+ * sont plus renvoyés par défaut, mais restent lisibles dans le journal en flash.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t post_adc_ack_handler(httpd_req_t *req) {
+    size_t seq = get_query_param(req, "seq", SIZE_MAX);
+    if (seq == SIZE_MAX) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing seq");
+    }
+    measure.ack(seq);
+
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "AckedSeq", measure.getAckedSeq());
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
+
     return ESP_OK;
 }
 
+/**
+ * @brief Version d'un Chrono : change à chaque mise à jour de ses statistiques globales.
+ * 
+ * @param ctx Le Chrono.
+ */
+static uint32_t chrono_version(void* ctx) {
+    return static_cast<Chrono*>(ctx)->getVersion();
+}
+
+/**
+ * @brief Rendu des statistiques globales d'un Chrono.
+ * 
+ * @param ctx Le Chrono.
+ */
+static void render_chrono(JsonWriter &writer, void* ctx) {
+    writer.beginObject();
+    static_cast<Chrono*>(ctx)->writeGlobalStats(writer);
+    writer.endObject();
+}
+
+static Snapshot adcChronoSnapshot(chrono_version, render_chrono, &adcChrono);
+static Snapshot dspChronoSnapshot(chrono_version, render_chrono, &dspChrono);
+static Snapshot resampleChronoSnapshot(chrono_version, render_chrono, &resampleChrono);
+
 /**
  * @brief Handler pour obtenir les statistiques de Chrono via une requête HTTP GET.
  * 
@@ -37,45 +288,323 @@ static esp_err_t get_adc_data_handler(httpd_req_t *req) {
  * @return esp_err_t ESP_OK si la requête est traitée avec succès.
  */
 static esp_err_t get_adc_chrono_handler(httpd_req_t *req) {
+    return adcChronoSnapshot.serve(req);
+}
+
+/**
+ * @brief Handler pour obtenir les statistiques de Chrono du traitement DSP via une requête HTTP GET.
+ * 
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_dsp_chrono_handler(httpd_req_t *req) {
+    return dspChronoSnapshot.serve(req);
+}
+
+/**
+ * @brief Handler pour obtenir les statistiques de Chrono du rééchantillonnage via une requête HTTP GET.
+ * 
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_resample_chrono_handler(httpd_req_t *req) {
+    return resampleChronoSnapshot.serve(req);
+}
+
+/**
+ * @brief Handler pour obtenir l'état du journal des paquets en flash via une requête HTTP GET.
+ * 
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_log_handler(httpd_req_t *req) {
+    cJSON *json = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(json, "FirstSeq", flashLog.getFirstSeq());
+    cJSON_AddNumberToObject(json, "NextSeq", flashLog.getNextSeq());
+    cJSON_AddNumberToObject(json, "Sectors", flashLog.getNbSectors());
+    cJSON_AddNumberToObject(json, "PacketsPerSector", flashLog.getSlotsPerSector());
+    cJSON_AddNumberToObject(json, "ErasedSectors", flashLog.getNbErased());
+    cJSON_AddNumberToObject(json, "CorruptedPackets", flashLog.getNbCorrupted());
+    cJSON_AddNumberToObject(json, "WriteErrors", flashLog.getNbWriteErrors());
+    cJSON_AddNumberToObject(json, "AckedSeq", measure.getAckedSeq());
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
 
-    //xSemaphoreTake(mutex, portMAX_DELAY); // Prendre le mutex pour accéder aux valeurs ADC en toute sécurité
-    
-    
-    std::string json_string = adcChrono.getGlobalStats();
-    //xSemaphoreGive(mutex); // Libérer le mutex
-    
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string.c_str(), json_string.length());
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
 
     return ESP_OK;
 }
 
+/**
+ * @brief Handler WebSocket du flux des valeurs de chaque période.
+ * 
+ * À la poignée de main, la session est abonnée au flux (voir liveStream.h pour le format
+ * des messages). Les messages reçus du client sont lus et ignorés.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès, ESP_FAIL pour fermer la session.
+ */
+static esp_err_t stream_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        return liveStream.addClient(httpd_req_to_sockfd(req)) ? ESP_OK : ESP_FAIL;
+    }
 
+    uint8_t buffer[16];
+    httpd_ws_frame_t frame = {};
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK || frame.len > sizeof(buffer)) {
+        return ESP_FAIL;
+    }
+    frame.payload = buffer;
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
 
-static esp_err_t get_memory_handler(httpd_req_t *req) {
+/**
+ * @brief Appelée par le serveur à la fermeture d'une session : désabonne la session du flux.
+ * 
+ * @param hd Handle du serveur web.
+ * @param sockfd Socket de la session.
+ */
+static void close_session(httpd_handle_t hd, int sockfd) {
+    liveStream.removeClient(sockfd);
+    close(sockfd);
+}
 
+/**
+ * @brief Handler pour obtenir les compteurs du flux des périodes via une requête HTTP GET.
+ * 
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_stream_stats_handler(httpd_req_t *req) {
     cJSON *json = cJSON_CreateObject();
 
-    multi_heap_info_t info;
-    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    cJSON_AddNumberToObject(json, "Clients", liveStream.getNbClients());
+    cJSON_AddNumberToObject(json, "Periods", liveStream.getNbFrames());
+    cJSON_AddNumberToObject(json, "RingDroppedPeriods", liveStream.getNbRingDropped());
+    cJSON_AddNumberToObject(json, "SentPeriods", liveStream.getNbSent());
+    cJSON_AddNumberToObject(json, "DroppedPeriods", liveStream.getNbDropped());
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
 
-    cJSON_AddNumberToObject(json, "Total heap size (kB)", float(info.total_free_bytes + info.total_allocated_bytes) / 1000.);
-    cJSON_AddNumberToObject(json, "Free heap size (kB)", float(info.total_free_bytes) / 1000.);
-    cJSON_AddNumberToObject(json, "Allocated heap size (kB)", float(info.total_allocated_bytes) / 1000.);
-    cJSON_AddNumberToObject(json, "Minimum free heap size (kB)", float(info.minimum_free_bytes) / 1000.);
+    return ESP_OK;
+}
 
-    std::string json_string = cJSON_Print(json);
+/**
+ * @brief Handler pour obtenir l'état du ring de blocs ADC via une requête HTTP GET.
+ * 
+ * Cette fonction retourne le remplissage et les compteurs d'overrun du ring entre
+ * l'acquisition et la tâche DSP, ainsi que les compteurs du démultiplexeur.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_adc_ring_handler(httpd_req_t *req) {
+
+    cJSON *json = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(json, "Capacity", adcRing.capacity());
+    cJSON_AddNumberToObject(json, "Used", adcRing.size());
+    cJSON_AddNumberToObject(json, "HighWater", adcRing.getHighWater());
+    cJSON_AddNumberToObject(json, "Pushed", adcRing.getNbPushed());
+    cJSON_AddNumberToObject(json, "Overrun", adcRing.getNbOverrun());
+    cJSON_AddNumberToObject(json, "InvalidSamples", adcDemux.getNbInvalid());
+    cJSON_AddNumberToObject(json, "DiscardedSamples", adcDemux.getNbDiscarded());
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
 
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string.c_str(), json_string.length());
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
 
     return ESP_OK;
 }
 
-static esp_err_t get_time_handler(httpd_req_t *req) {
+/**
+ * @brief Handler pour obtenir les échéances de l'acquisition via une requête HTTP GET.
+ * 
+ * Cette fonction retourne les compteurs de trames ADC perdues (pool du driver plein),
+ * manquées, lues en retard ou hors budget de gigue, l'histogramme de la gigue des
+ * intervalles entre trames, et la période d'échantillonnage mesurée.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_adc_deadline_handler(httpd_req_t *req) {
 
     cJSON *json = cJSON_CreateObject();
 
+    cJSON_AddNumberToObject(json, "Frames", deadlineMonitor.getNbFrames());
+    cJSON_AddNumberToObject(json, "DroppedFrames", deadlineMonitor.getNbDropped());
+    cJSON_AddNumberToObject(json, "MissedFrames", deadlineMonitor.getNbMissed());
+    cJSON_AddNumberToObject(json, "LateFrames", deadlineMonitor.getNbLate());
+    cJSON_AddNumberToObject(json, "JitterOverBudget", deadlineMonitor.getNbJitterOver());
+    cJSON_AddNumberToObject(json, "UnmonitoredFrames", deadlineMonitor.getNbUnmonitored());
+    cJSON_AddNumberToObject(json, "LatencyBudget(µs)", DEADLINE_LATENCY_BUDGET);
+    cJSON_AddNumberToObject(json, "MaxLatency(µs)", deadlineMonitor.getMaxLatency());
+    cJSON_AddNumberToObject(json, "JitterBudget(µs)", DEADLINE_JITTER_BUDGET);
+    cJSON_AddNumberToObject(json, "MaxJitter(µs)", deadlineMonitor.getMaxJitter());
+    cJSON_AddNumberToObject(json, "SamplePeriod(µs)", deadlineMonitor.getSamplePeriod());
+    cJSON_AddNumberToObject(json, "NominalSamplePeriod(µs)", TIM_PERIOD);
+
+    cJSON *histogram = cJSON_AddObjectToObject(json, "Jitter(µs)");
+    char key[16];
+    for (uint8_t i = 0; i < DEADLINE_JITTER_BINS; i++) {
+        if (i < DEADLINE_JITTER_BINS - 1) {
+            snprintf(key, sizeof(key), "<%lu", (unsigned long)DeadlineMonitor::getJitterBound(i));
+        }
+        else {
+            snprintf(key, sizeof(key), ">=%lu", (unsigned long)DeadlineMonitor::getJitterBound(i - 1));
+        }
+        cJSON_AddNumberToObject(histogram, key, deadlineMonitor.getJitterCount(i));
+    }
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Handler pour obtenir le placement des tâches via une requête HTTP GET.
+ * 
+ * Cette fonction retourne, pour chaque étape du pipeline, le placement déclaré (cœur,
+ * priorité, pile, file d'entrée) et le placement réel de la tâche, avec le minimum de pile
+ * libre atteint depuis son démarrage.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_tasks_handler(httpd_req_t *req) {
+
+    cJSON *json = cJSON_CreateArray();
+
+    for (uint8_t i = 0; i < NB_TASKS; i++) {
+        const TaskPlacement &placement = tasks_get(static_cast<TaskId>(i));
+        TaskHandle_t handle = tasks_getHandle(static_cast<TaskId>(i));
+        cJSON *task = cJSON_CreateObject();
+
+        cJSON_AddStringToObject(task, "Name", placement.name);
+        cJSON_AddBoolToObject(task, "Running", handle != nullptr);
+        cJSON_AddNumberToObject(task, "Core", placement.core);
+        cJSON_AddNumberToObject(task, "Priority", placement.priority);
+        cJSON_AddNumberToObject(task, "Stack(bytes)", placement.stackSize);
+        if (placement.input != nullptr) {
+            cJSON_AddStringToObject(task, "Input", placement.input);
+            cJSON_AddNumberToObject(task, "InputDepth", placement.inputDepth);
+        }
+        if (handle != nullptr) {
+            BaseType_t core = xTaskGetAffinity(handle);
+            cJSON_AddNumberToObject(task, "ActualCore", (core == tskNO_AFFINITY) ? -1 : core);
+            cJSON_AddNumberToObject(task, "ActualPriority", uxTaskPriorityGet(handle));
+            cJSON_AddNumberToObject(task, "StackHighWater(bytes)", uxTaskGetStackHighWaterMark(handle));
+        }
+        cJSON_AddItemToArray(json, task);
+    }
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Handler pour obtenir les compteurs des requêtes HTTP via une requête HTTP GET.
+ * 
+ * Cette fonction retourne, pour chaque URI servie par les workers, le nombre de requêtes
+ * servies, refusées (503, file pleine) et en échec, la latence moyenne et maximale (attente
+ * dans la file comprise) et l'attente maximale dans la file, en ms.
+ * @param req La requête HTTP reçue.
+ * @return esp_err_t ESP_OK si la requête est traitée avec succès.
+ */
+static esp_err_t get_http_handler(httpd_req_t *req) {
+
+    cJSON *json = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(json, "Workers", HTTP_NB_WORKERS);
+    cJSON_AddNumberToObject(json, "QueueDepth", HTTP_QUEUE_DEPTH);
+    cJSON *endpoints = cJSON_AddObjectToObject(json, "Endpoints");
+    HttpHandler::Stats stats;
+    for (size_t i = 0; i < httpHandler.getNbEndpoints(); i++) {
+        httpHandler.getStats(i, stats);
+        cJSON *endpoint = cJSON_AddObjectToObject(endpoints, stats.uri);
+        cJSON_AddNumberToObject(endpoint, "Requests", stats.nbRequests);
+        cJSON_AddNumberToObject(endpoint, "Rejected", stats.nbRejected);
+        cJSON_AddNumberToObject(endpoint, "Failed", stats.nbFailed);
+        cJSON_AddNumberToObject(endpoint, "MeanLatency(ms)", stats.meanLatency);
+        cJSON_AddNumberToObject(endpoint, "MaxLatency(ms)", stats.maxLatency);
+        cJSON_AddNumberToObject(endpoint, "MaxWait(ms)", stats.maxWait);
+    }
+
+    char* json_string = cJSON_Print(json);
+    cJSON_Delete(json);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_string);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Version de l'état de la mémoire : valeurs vivantes, rafraîchies au plus une fois par SNAPSHOT_LIVE_PERIOD.
+ */
+static uint32_t memory_version(void* ctx) {
+    return esp_timer_get_time() / SNAPSHOT_LIVE_PERIOD;
+}
+
+/**
+ * @brief Rendu de l'état de la mémoire.
+ */
+static void render_memory(JsonWriter &writer, void* ctx) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+
+    writer.beginObject();
+    writer.addNumber("Total heap size (kB)", float(info.total_free_bytes + info.total_allocated_bytes) / 1000.);
+    writer.addNumber("Free heap size (kB)", float(info.total_free_bytes) / 1000.);
+    writer.addNumber("Allocated heap size (kB)", float(info.total_allocated_bytes) / 1000.);
+    writer.addNumber("Minimum free heap size (kB)", float(info.minimum_free_bytes) / 1000.);
+
+    // Le ring de paquets est alloué une fois au démarrage : sa taille ne varie pas
+    writer.addNumber("Packet ring size (kB)", float(measure.getPacketRingBytes()) / 1000.);
+    writer.addBool("Packet ring in PSRAM", measure.isPacketRingInPsram());
+    writer.addNumber("Buffered packets", measure.getNbPackets());
+    writer.addNumber("Dropped packets", measure.getNbDroppedPackets());
+    writer.addNumber("Rollup size (kB)", float(rollup.getBytes()) / 1000.);
+    writer.endObject();
+}
+
+static Snapshot memorySnapshot(memory_version, render_memory);
+
+static esp_err_t get_memory_handler(httpd_req_t *req) {
+    return memorySnapshot.serve(req);
+}
+
+/**
+ * @brief Version de l'heure : la seconde courante.
+ */
+static uint32_t time_version(void* ctx) {
+    return get_timestamp();
+}
+
+/**
+ * @brief Rendu de l'heure courante.
+ */
+static void render_time(JsonWriter &writer, void* ctx) {
     time_t now = get_timestamp();
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
@@ -87,14 +616,15 @@ static esp_err_t get_time_handler(httpd_req_t *req) {
              timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec,
              timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900);
 
-    cJSON_AddStringToObject(json, "Datetime", buffer);
-
-    std::string json_string = cJSON_Print(json);
+    writer.beginObject();
+    writer.addString("Datetime", buffer);
+    writer.endObject();
+}
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string.c_str(), json_string.length());
+static Snapshot timeSnapshot(time_version, render_time);
 
-    return ESP_OK;
+static esp_err_t get_time_handler(httpd_req_t *req) {
+    return timeSnapshot.serve(req);
 }
 
 /**
@@ -120,49 +650,50 @@ static esp_err_t trigger_action_handler(httpd_req_t *req) {
  * @return httpd_handle_t Handle du serveur web, ou NULL si le démarrage échoue.
  */
 httpd_handle_t start_webserver(void) {
+    const TaskPlacement &placement = tasks_get(HTTP_TASK);
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.max_uri_handlers = HTTP_MAX_ENDPOINTS;
+    config.stack_size = placement.stackSize;
+    config.task_priority = placement.priority;
+    config.core_id = placement.core;
+    config.max_open_sockets = placement.inputDepth;
+    config.close_fn = close_session;
     httpd_handle_t server = NULL;
     
     if (httpd_start(&server, &config) == ESP_OK) {
-        httpd_uri_t uri_getAdcData = {
-            .uri      = "/api/adc/data",
-            .method   = HTTP_GET,
-            .handler  = get_adc_data_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &uri_getAdcData);
-
-        httpd_uri_t uri_getAdcChrono = {
-            .uri      = "/api/adc/chrono",
-            .method   = HTTP_GET,
-            .handler  = get_adc_chrono_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &uri_getAdcChrono);
-        
-        httpd_uri_t uri_getMemory = {
-            .uri      = "/api/memory",
+        // Servies par les workers : la tâche du serveur ne formate aucune réponse
+        httpHandler.registerUri(server, "/api/adc/data", HTTP_GET, get_adc_data_handler);
+        httpHandler.registerUri(server, "/api/adc/data.bin", HTTP_GET, get_adc_data_bin_handler);
+        httpHandler.registerUri(server, "/api/adc/ack", HTTP_POST, post_adc_ack_handler);
+        httpHandler.registerUri(server, "/api/energy", HTTP_GET, get_energy_handler);
+        httpHandler.registerUri(server, "/api/errors", HTTP_GET, get_errors_handler);
+#if PROFILING
+        httpHandler.registerUri(server, "/api/profile", HTTP_GET, get_profile_handler);
+#endif
+        httpHandler.registerUri(server, "/api/adc/chrono", HTTP_GET, get_adc_chrono_handler);
+        httpHandler.registerUri(server, "/api/dsp/chrono", HTTP_GET, get_dsp_chrono_handler);
+        httpHandler.registerUri(server, "/api/resample/chrono", HTTP_GET, get_resample_chrono_handler);
+        httpHandler.registerUri(server, "/api/adc/ring", HTTP_GET, get_adc_ring_handler);
+        httpHandler.registerUri(server, "/api/adc/deadline", HTTP_GET, get_adc_deadline_handler);
+        httpHandler.registerUri(server, "/api/tasks", HTTP_GET, get_tasks_handler);
+        httpHandler.registerUri(server, "/api/http", HTTP_GET, get_http_handler);
+        httpHandler.registerUri(server, "/api/log", HTTP_GET, get_log_handler);
+        httpHandler.registerUri(server, "/api/stream/stats", HTTP_GET, get_stream_stats_handler);
+        httpHandler.registerUri(server, "/api/memory", HTTP_GET, get_memory_handler);
+        httpHandler.registerUri(server, "/api/time", HTTP_GET, get_time_handler);
+        httpHandler.registerUri(server, "/api/action", HTTP_POST, trigger_action_handler);
+
+        // Le WebSocket reste sur la tâche du serveur (envois asynchrones, voir liveStream.h)
+        httpd_uri_t uri_stream = {
+            .uri      = "/api/stream",
             .method   = HTTP_GET,
-            .handler  = get_memory_handler,
-            .user_ctx = NULL
+            .handler  = stream_handler,
+            .user_ctx = NULL,
+            .is_websocket = true
         };
-        httpd_register_uri_handler(server, &uri_getMemory);
-        
-        httpd_uri_t uri_getTime = {
-            .uri      = "/api/time",
-            .method   = HTTP_GET,
-            .handler  = get_time_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &uri_getTime);
+        httpd_register_uri_handler(server, &uri_stream);
 
-        httpd_uri_t uri_post = {
-            .uri      = "/api/action",
-            .method   = HTTP_POST,
-            .handler  = trigger_action_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &uri_post);
+        liveStream.begin(server);
     }
     
     return server;
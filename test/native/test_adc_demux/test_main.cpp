@@ -0,0 +1,114 @@
+#include <unity.h>
+
+#include <hal/adc_types.h>
+
+#include "adc.h"
+#include "adcDemux.h"
+#include "adcSimulator.h"
+
+static adc_digi_output_data_t records[ADC_BLOCK_SIZE * NB_CHANNELS + 8];
+static AdcBlock block;
+
+
+void setUp() {}
+void tearDown() {}
+
+static void setRecord(adc_digi_output_data_t &record, uint8_t channel, uint16_t data, uint8_t unit = ADC_UNIT_1)
+{
+    record.val = 0;
+    record.type2.data = data;
+    record.type2.channel = channel;
+    record.type2.unit = unit;
+}
+
+// Sample i of logical channel j is j * 100 + i
+static uint32_t fillSets(const uint8_t* adcChannels, uint16_t nbSets)
+{
+    uint32_t n = 0;
+    for (uint16_t i = 0; i < nbSets; i++) {
+        for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+            setRecord(records[n++], adcChannels[j], j * 100 + i);
+        }
+    }
+    return n;
+}
+
+void test_routes_each_record_to_its_logical_channel()
+{
+    // Hardware channels in reverse order of the logical ones
+    uint8_t adcChannels[NB_CHANNELS];
+    for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+        adcChannels[j] = NB_CHANNELS - 1 - j;
+    }
+    AdcDemux demux(adcChannels);
+
+    uint32_t n = fillSets(adcChannels, ADC_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL_UINT16(ADC_BLOCK_SIZE, demux.parse(reinterpret_cast<uint8_t*>(records), n * sizeof(records[0]), block));
+    TEST_ASSERT_EQUAL_UINT16(ADC_BLOCK_SIZE, block.nbSamples);
+    for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+        for (uint16_t i = 0; i < ADC_BLOCK_SIZE; i++) {
+            TEST_ASSERT_EQUAL_UINT16(j * 100 + i, block.samples[j][i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbInvalid());
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbDiscarded());
+}
+
+void test_skips_records_of_another_unit_or_channel()
+{
+    AdcDemux demux(ActiveLayout::adcChannels);
+
+    uint32_t n = fillSets(ActiveLayout::adcChannels, 4);
+    setRecord(records[n++], ActiveLayout::adcChannels[0], 4000, ADC_UNIT_2);
+    setRecord(records[n++], 15, 4000);
+    TEST_ASSERT_EQUAL_UINT16(4, demux.parse(reinterpret_cast<uint8_t*>(records), n * sizeof(records[0]), block));
+    TEST_ASSERT_EQUAL_UINT16(3, block.samples[0][3]);
+    TEST_ASSERT_EQUAL_UINT32(2, demux.getNbInvalid());
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbDiscarded());
+}
+
+void test_discards_the_incomplete_last_set()
+{
+    AdcDemux demux(ActiveLayout::adcChannels);
+
+    // The last set lacks its last channel: the other channels drop their extra sample
+    uint32_t n = fillSets(ActiveLayout::adcChannels, 10) - 1;
+    TEST_ASSERT_EQUAL_UINT16(9, demux.parse(reinterpret_cast<uint8_t*>(records), n * sizeof(records[0]), block));
+    TEST_ASSERT_EQUAL_UINT32(NB_CHANNELS - 1, demux.getNbDiscarded());
+    for (uint8_t j = 0; j < NB_CHANNELS; j++) {
+        TEST_ASSERT_EQUAL_UINT16(j * 100 + 8, block.samples[j][8]);
+    }
+
+    // A frame longer than a block: the records past ADC_BLOCK_SIZE sets are invalid
+    n = fillSets(ActiveLayout::adcChannels, ADC_BLOCK_SIZE + 1);
+    TEST_ASSERT_EQUAL_UINT16(ADC_BLOCK_SIZE, demux.parse(reinterpret_cast<uint8_t*>(records), n * sizeof(records[0]), block));
+    TEST_ASSERT_EQUAL_UINT32(NB_CHANNELS, demux.getNbInvalid());
+}
+
+void test_parses_simulated_frames()
+{
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    static uint8_t frame[ADC_FRAME_SIZE];
+
+    for (uint8_t f = 0; f < 16; f++) {
+        uint32_t size = simulator.fill(frame, sizeof(frame));
+        TEST_ASSERT_EQUAL_UINT32(ADC_FRAME_SIZE, size);
+        TEST_ASSERT_EQUAL_UINT16(ADC_BLOCK_SIZE, demux.parse(frame, size, block));
+        for (uint16_t i = 0; i < ADC_BLOCK_SIZE; i++) {
+            TEST_ASSERT_EQUAL_UINT16(SIM_VREF, block.samples[VREF_ID][i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbInvalid());
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbDiscarded());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_routes_each_record_to_its_logical_channel);
+    RUN_TEST(test_skips_records_of_another_unit_or_channel);
+    RUN_TEST(test_discards_the_incomplete_last_set);
+    RUN_TEST(test_parses_simulated_frames);
+    return UNITY_END();
+}
@@ -0,0 +1,70 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "currentBank.h"
+
+#define BENCH_NB_PERIODS    100000
+#define SIM_VREF_COUNTS     2048
+#define SIM_AMPLITUDE       600.f           // ADC counts, peak of the current 0 (the current i gets 1 / (i + 1) of it)
+
+static const float PERIOD_TIME = NB_SAMPLES * (float)CurrentBank<ActiveLayout>::SAMPLE_TIME;
+
+// One mains period of exactly NB_SAMPLES conversion sets: sines on the currents, tension in phase
+static uint16_t sets[NB_SAMPLES][NB_CHANNELS];
+static float tension[NB_SAMPLES];
+static CurrentBank<ActiveLayout> bank;
+
+
+void setUp()
+{
+    for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+        float phase = 2.f * (float)M_PI * n / NB_SAMPLES;
+        for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+            sets[n][i] = (uint16_t)lroundf(SIM_VREF_COUNTS + SIM_AMPLITUDE / (i + 1) * sinf(phase));
+        }
+        sets[n][TENSION_ID] = SIM_VREF_COUNTS;
+        sets[n][VREF_ID] = SIM_VREF_COUNTS;
+        tension[n] = 325.f * sinf(phase);
+    }
+    bank.init();
+}
+
+void tearDown() {}
+
+/**
+ * @brief Per-sample cost of the structure-of-arrays bank: setRawVals and calcSample on every
+ * conversion set, calcPeriod on every NB_SAMPLES sets
+ */
+void test_current_bank_throughput()
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < BENCH_NB_PERIODS; p++) {
+        for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+            bank.setRawVals(sets[n]);
+            bank.calcSample(tension[n]);
+        }
+        bank.calcPeriod(325.f / sqrtf(2.f), PERIOD_TIME);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The result is checked, so that the loop cannot be optimized away
+    float expected = SIM_AMPLITUDE * ActiveLayout::calibA[0] / sqrtf(2.f);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-3f, expected, bank.getLastRms(0));
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-3f, expected, bank.getData(0).rms.mean);
+
+    double nbSets = (double)BENCH_NB_PERIODS * NB_SAMPLES;
+    char message[160];
+    snprintf(message, sizeof(message), "%.0f sets in %.3f s: %.1f ns per set, %.1f M sets/s (%.1f M current samples/s)",
+        nbSets, seconds, seconds * 1e9 / nbSets, nbSets / seconds / 1e6, nbSets * NB_CURRENTS / seconds / 1e6);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_current_bank_throughput);
+    return UNITY_END();
+}
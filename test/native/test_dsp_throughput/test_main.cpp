@@ -0,0 +1,67 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <chrono>
+
+#include "adc.h"
+#include "adcSimulator.h"
+#include "adcDemux.h"
+#include "measure.h"
+#include "harmonics.h"
+
+#define SIMULATED_TIME      (MEASURE_PACKET_PERIOD + 10)        // s, one packet and a bit
+
+static uint8_t frame[ADC_FRAME_SIZE];
+static AdcBlock block;
+
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * @brief Feed the simulated frames through the demux and the measure, as adc_task and dsp_task do
+ *
+ * Only the DSP path is timed: the frame generation and the harmonic analysis (core 0 on the
+ * target) run outside the measured intervals.
+ */
+void test_dsp_throughput()
+{
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    TEST_ASSERT_TRUE(measure.begin(0));
+
+    uint32_t nbBlocks = (uint32_t)(SIMULATED_TIME * 1000000. / ADC_BLOCK_PERIOD);
+    uint64_t nbSets = 0;
+    std::chrono::steady_clock::duration dspTime(0);
+
+    for (uint32_t b = 0; b < nbBlocks; b++) {
+        uint32_t size = simulator.fill(frame, sizeof(frame));
+
+        auto start = std::chrono::steady_clock::now();
+        uint16_t nbSamples = demux.parse(frame, size, block);
+        measure.adcBlockCallback(block);
+        dspTime += std::chrono::steady_clock::now() - start;
+
+        harmonics.process();
+        nbSets += nbSamples;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbInvalid());
+    TEST_ASSERT_EQUAL_UINT32(0, demux.getNbDiscarded());
+    TEST_ASSERT_EQUAL(1, measure.getNbPackets());
+
+    double seconds = std::chrono::duration<double>(dspTime).count();
+    double setsPerSecond = nbSets / seconds;
+    char message[160];
+    snprintf(message, sizeof(message), "%llu sets of %u channels in %.3f s: %.2f Msamples/s (%.0fx real time)",
+        (unsigned long long)nbSets, NB_CHANNELS, seconds, setsPerSecond * NB_CHANNELS / 1e6, setsPerSecond / SAMPLE_RATE);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(setsPerSecond > SAMPLE_RATE);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dsp_throughput);
+    return UNITY_END();
+}
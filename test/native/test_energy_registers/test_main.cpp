@@ -0,0 +1,194 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+
+#include "energyRegisters.h"
+
+#define TEST_FREQUENCY      50.f                    // Hz
+#define TEST_HOUR_PERIODS   (3600 * 50)             // Periods of one hour
+
+
+void setUp()
+{
+    nvs_flash_erase();
+}
+
+void tearDown() {}
+
+static void getKey(char* key, unsigned nbCurrents)
+{
+    snprintf(key, ENERGY_NVS_KEY_SIZE, "%s%u_%u", ENERGY_NVS_KEY, ENERGY_NVS_VERSION, nbCurrents);
+}
+
+static PeriodFrame makeFrame(uint32_t seq, float power)
+{
+    PeriodFrame frame = {};
+    frame.seq = seq;
+    frame.frequency = TEST_FREQUENCY;
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        frame.activePower[i] = power;
+    }
+    return frame;
+}
+
+/**
+ * @brief One hour of periods: the import and export registers hold the energy in Q32.32 W.h
+ */
+void test_register_accumulation()
+{
+    EnergyRegisters registers;
+    TEST_ASSERT_TRUE(registers.begin());
+
+    // Channel 0 imports 1 kW, channel 1 exports 500 W, channel 2 is idle, the others alternate +-2 kW
+    for (uint32_t n = 0; n < TEST_HOUR_PERIODS; n++) {
+        PeriodFrame frame = makeFrame(n, 0.f);
+        frame.activePower[0] = 1000.f;
+        frame.activePower[1] = -500.f;
+        for (uint8_t i = 3; i < NB_CURRENTS; i++) {
+            frame.activePower[i] = (n % 2 == 0) ? 2000.f : -2000.f;
+        }
+        registers.addPeriod(frame);
+    }
+
+    EnergyRegisters::Values values;
+    registers.read(values);
+    TEST_ASSERT_TRUE(fabs(EnergyRegisters::toWh(values.importEnergy[0]) - 1000.) < 1000. * 1e-6);
+    TEST_ASSERT_TRUE(values.exportEnergy[0] == 0);
+    TEST_ASSERT_TRUE(values.importEnergy[1] == 0);
+    TEST_ASSERT_TRUE(fabs(EnergyRegisters::toWh(values.exportEnergy[1]) - 500.) < 500. * 1e-6);
+    TEST_ASSERT_TRUE(values.importEnergy[2] == 0 && values.exportEnergy[2] == 0);
+    for (uint8_t i = 3; i < NB_CURRENTS; i++) {
+        TEST_ASSERT_TRUE(fabs(EnergyRegisters::toWh(values.importEnergy[i]) - 1000.) < 1000. * 1e-6);
+        TEST_ASSERT_TRUE(values.importEnergy[i] == values.exportEnergy[i]);
+    }
+
+    // Resolution: the energy of a period of 1 W is truncated to a whole register unit (0.84 µJ)
+    EnergyRegisters small;
+    small.addPeriod(makeFrame(0, 1.f));
+    small.read(values);
+    double expected = 1. / TEST_FREQUENCY / 3600. * (double)(1ull << ENERGY_FRAC_BITS);
+    TEST_ASSERT_TRUE(fabs((double)values.importEnergy[0] - expected) <= 1.);
+}
+
+/**
+ * @brief A checkpoint is restored at the next boot, and the registers go on from it
+ */
+void test_checkpoint_restore()
+{
+    EnergyRegisters::Values saved;
+    {
+        EnergyRegisters registers;
+        TEST_ASSERT_TRUE(registers.begin());
+        for (uint32_t n = 0; n < 1000; n++) {
+            registers.addPeriod(makeFrame(n, 1500.f));
+        }
+        TEST_ASSERT_TRUE(registers.checkpoint());
+        TEST_ASSERT_EQUAL_UINT32(1, registers.getNbCheckpoints());
+        registers.read(saved);
+
+        // Within ENERGY_CHECKPOINT_PERIOD, the new energy is not written
+        registers.addPeriod(makeFrame(1000, 1500.f));
+        TEST_ASSERT_TRUE(registers.checkpoint());
+        TEST_ASSERT_EQUAL_UINT32(1, registers.getNbCheckpoints());
+    }
+
+    EnergyRegisters registers;
+    TEST_ASSERT_TRUE(registers.begin());
+    TEST_ASSERT_TRUE(registers.isRestored());
+    EnergyRegisters::Values values;
+    registers.read(values);
+    TEST_ASSERT_EQUAL_MEMORY(&saved, &values, sizeof(values));
+
+    registers.addPeriod(makeFrame(0, 1500.f));
+    registers.read(values);
+    TEST_ASSERT_TRUE(values.importEnergy[0] > saved.importEnergy[0]);
+}
+
+/**
+ * @brief Registers that did not change since the last checkpoint are not written again
+ */
+void test_unchanged_registers_not_written()
+{
+    EnergyRegisters registers;
+    TEST_ASSERT_TRUE(registers.begin());
+    TEST_ASSERT_TRUE(registers.checkpoint());
+    TEST_ASSERT_EQUAL_UINT32(0, registers.getNbCheckpoints());
+
+    nvs_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_ERR_NVS_NOT_FOUND, nvs_open(ENERGY_NVS_NAMESPACE, NVS_READONLY, &handle));
+}
+
+/**
+ * @brief A checkpoint that cannot be restored is kept: the checkpoints are disabled
+ */
+void test_failed_restore_disables_checkpoints()
+{
+    char key[ENERGY_NVS_KEY_SIZE];
+    getKey(key, NB_CURRENTS);
+    uint8_t blob[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    nvs_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_set_blob(handle, key, blob, sizeof(blob)));
+    nvs_close(handle);
+
+    EnergyRegisters registers;
+    TEST_ASSERT_FALSE(registers.begin());
+    TEST_ASSERT_FALSE(registers.isRestored());
+    registers.addPeriod(makeFrame(0, 1000.f));
+    TEST_ASSERT_TRUE(registers.checkpoint());
+    TEST_ASSERT_EQUAL_UINT32(0, registers.getNbCheckpoints());
+
+    uint8_t stored[sizeof(blob)];
+    size_t size = sizeof(stored);
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open(ENERGY_NVS_NAMESPACE, NVS_READONLY, &handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_get_blob(handle, key, stored, &size));
+    nvs_close(handle);
+    TEST_ASSERT_EQUAL(sizeof(blob), size);
+    TEST_ASSERT_EQUAL_MEMORY(blob, stored, sizeof(blob));
+}
+
+/**
+ * @brief The registers of another layout are ignored and kept under their own key
+ */
+void test_other_layout_kept()
+{
+    char otherKey[ENERGY_NVS_KEY_SIZE];
+    getKey(otherKey, NB_CURRENTS + 1);
+    uint8_t blob[16] = {0};
+    nvs_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_set_blob(handle, otherKey, blob, sizeof(blob)));
+    nvs_close(handle);
+
+    EnergyRegisters registers;
+    TEST_ASSERT_TRUE(registers.begin());
+    TEST_ASSERT_TRUE(registers.isRestored());
+    EnergyRegisters::Values values;
+    registers.read(values);
+    TEST_ASSERT_TRUE(values.importEnergy[0] == 0);
+
+    registers.addPeriod(makeFrame(0, 1000.f));
+    TEST_ASSERT_TRUE(registers.checkpoint());
+    TEST_ASSERT_EQUAL_UINT32(1, registers.getNbCheckpoints());
+
+    size_t size = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open(ENERGY_NVS_NAMESPACE, NVS_READONLY, &handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_get_blob(handle, otherKey, nullptr, &size));
+    nvs_close(handle);
+    TEST_ASSERT_EQUAL(sizeof(blob), size);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_register_accumulation);
+    RUN_TEST(test_checkpoint_restore);
+    RUN_TEST(test_unchanged_registers_not_written);
+    RUN_TEST(test_failed_restore_disables_checkpoints);
+    RUN_TEST(test_other_layout_kept);
+    return UNITY_END();
+}
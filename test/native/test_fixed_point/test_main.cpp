@@ -0,0 +1,123 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "adc.h"
+#include "adcSimulator.h"
+#include "adcDemux.h"
+#include "currentBank.h"
+#include "fixedCurrentBank.h"
+
+#define SIM_FREQUENCY       49.7            // Hz, so that the periods end inside a sample
+#define AGREEMENT           1e-4f           // Relative
+
+static uint8_t frame[ADC_FRAME_SIZE];
+static AdcBlock block;
+static CurrentBank<ActiveLayout> floatBank;
+static FixedCurrentBank<ActiveLayout> fixedBank;
+static float worstAgreement;
+
+
+void setUp() {}
+void tearDown() {}
+
+static void assertAgree(const char* name, uint8_t i, float floatVal, float fixedVal)
+{
+    char message[120];
+    float agreement = fabsf(fixedVal - floatVal) / fabsf(floatVal);
+    if (agreement > worstAgreement) {
+        worstAgreement = agreement;
+    }
+    snprintf(message, sizeof(message), "%s of current %u: float %.7g, fixed %.7g", name, i, floatVal, fixedVal);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(fabsf(floatVal) * AGREEMENT, floatVal, fixedVal, message);
+}
+
+/**
+ * @brief Feed the same simulated conversion sets to both banks for a 5 minutes packet
+ *
+ * Each period ends inside a sample, which is split between the two periods with
+ * calcPartialSample, as Measure does at a zero crossing.
+ */
+void test_fixed_and_float_banks_agree()
+{
+    constexpr float Au = ActiveLayout::calibA[TENSION_ID];
+    constexpr float Bu = ActiveLayout::calibB[TENSION_ID];
+    const float sampleTime = CurrentBank<ActiveLayout>::SAMPLE_TIME;
+    const double samplesPerPeriod = 1000000. / (SIM_FREQUENCY * TIM_PERIOD);
+
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    simulator.setFrequency(SIM_FREQUENCY);
+
+    double nextEnd = samplesPerPeriod;
+    float periodWeight = 0.f;
+    float tensionSquares = 0.f;
+    uint32_t nbPeriods = 0;
+    uint64_t j = 0;
+    uint16_t data[NB_CHANNELS];
+
+    while (nbPeriods < MEASURE_PACKET_PERIOD * SIM_FREQUENCY) {
+        demux.parse(frame, simulator.fill(frame, sizeof(frame)), block);
+        for (uint16_t n = 0; n < block.nbSamples; n++, j++) {
+            for (uint8_t c = 0; c < NB_CHANNELS; c++) {
+                data[c] = block.samples[c][n];
+            }
+            int32_t u = (int32_t)data[TENSION_ID] - data[VREF_ID];
+            float U = Au * u + Bu;
+            floatBank.setRawVals(data);
+            fixedBank.setRawVals(data);
+
+            if (j + 1 < nextEnd) {
+                floatBank.calcSample(U);
+                fixedBank.calcSample(u);
+                periodWeight += 1.f;
+                tensionSquares += U * U;
+                continue;
+            }
+
+            float fraction = (float)(nextEnd - j);
+            floatBank.calcPartialSample(U, fraction);
+            fixedBank.calcPartialSample(u, fraction);
+            periodWeight += fraction;
+            tensionSquares += U * U * fraction;
+
+            float tensionRms = sqrtf(tensionSquares / periodWeight);
+            floatBank.calcPeriod(tensionRms, periodWeight * sampleTime);
+            fixedBank.calcPeriod(tensionRms, periodWeight * sampleTime);
+            nbPeriods++;
+
+            floatBank.calcPartialSample(U, 1.f - fraction);
+            fixedBank.calcPartialSample(u, 1.f - fraction);
+            periodWeight = 1.f - fraction;
+            tensionSquares = U * U * (1.f - fraction);
+            nextEnd += samplesPerPeriod;
+        }
+    }
+
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        Current::Data floatData = floatBank.getData(i);
+        Current::Data fixedData = fixedBank.getData(i);
+        assertAgree("RMS", i, floatData.rms.mean, fixedData.rms.mean);
+        assertAgree("RMS min", i, floatData.rms.min, fixedData.rms.min);
+        assertAgree("RMS max", i, floatData.rms.max, fixedData.rms.max);
+        assertAgree("P", i, floatData.activePower.mean, fixedData.activePower.mean);
+        assertAgree("S", i, floatData.apparentPower.mean, fixedData.apparentPower.mean);
+        assertAgree("PF", i, floatData.powerFactor.mean, fixedData.powerFactor.mean);
+        assertAgree("Energy", i, floatData.energy, fixedData.energy);
+        TEST_ASSERT_EQUAL_FLOAT(floatData.range.min, fixedData.range.min);
+        TEST_ASSERT_EQUAL_FLOAT(floatData.range.max, fixedData.range.max);
+    }
+
+    char message[80];
+    snprintf(message, sizeof(message), "%lu periods, worst relative difference %.2e",
+             (unsigned long)nbPeriods, worstAgreement);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_and_float_banks_agree);
+    return UNITY_END();
+}
@@ -0,0 +1,334 @@
+#include <unity.h>
+
+#include <string.h>
+#include <vector>
+
+#include "flashLog.h"
+#include "flashStorage.h"
+
+#define TEST_SECTOR_SIZE    1024
+#define TEST_NB_SECTORS     4
+#define TEST_PAYLOAD_SIZE   100         // 9 slots per sector
+
+
+// NOR flash in RAM: a write clears bits, an erase sets a whole sector to 0xFF.
+// A write may be cut after a number of bytes, as by a power cut, or fail.
+class RamFlash : public FlashStorage
+{
+public:
+    RamFlash() : m_data(TEST_SECTOR_SIZE * TEST_NB_SECTORS, 0xFF), m_tearAfter(SIZE_MAX), m_fail(false) {};
+
+    size_t getSize() override {return m_data.size();}
+    size_t getSectorSize() override {return TEST_SECTOR_SIZE;}
+
+    bool read(size_t offset, void* data, size_t size) override
+    {
+        if (offset + size > m_data.size()) {
+            return false;
+        }
+        memcpy(data, &m_data[offset], size);
+        return true;
+    }
+
+    bool write(size_t offset, const void* data, size_t size) override
+    {
+        if (m_fail || offset + size > m_data.size()) {
+            return false;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size && m_tearAfter > 0; i++, m_tearAfter--) {
+            m_data[offset + i] &= bytes[i];
+        }
+        return true;
+    }
+
+    bool eraseSector(size_t sector) override
+    {
+        if (m_fail || (sector + 1) * TEST_SECTOR_SIZE > m_data.size()) {
+            return false;
+        }
+        memset(&m_data[sector * TEST_SECTOR_SIZE], 0xFF, TEST_SECTOR_SIZE);
+        return true;
+    }
+
+    std::vector<uint8_t> m_data;
+    size_t m_tearAfter;                 // Bytes still written before the power cut
+    bool m_fail;
+};
+
+
+void setUp() {}
+void tearDown() {}
+
+static void fillPayload(uint32_t seq, uint8_t* payload, uint16_t size = TEST_PAYLOAD_SIZE)
+{
+    for (uint16_t i = 0; i < size; i++) {
+        payload[i] = (uint8_t)(seq * 7 + i);
+    }
+}
+
+static void appendRange(FlashLog &log, uint32_t firstSeq, uint32_t endSeq)
+{
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    for (uint32_t seq = firstSeq; seq < endSeq; seq++) {
+        fillPayload(seq, payload);
+        TEST_ASSERT_TRUE(log.append(seq, payload));
+    }
+}
+
+static bool readMatches(FlashLog &log, uint32_t seq)
+{
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    uint8_t expected[TEST_PAYLOAD_SIZE];
+    fillPayload(seq, expected);
+    return log.read(seq, payload) && memcmp(payload, expected, TEST_PAYLOAD_SIZE) == 0;
+}
+
+static size_t slotOffset(FlashLog &log, uint32_t seq)
+{
+    size_t sector = (seq / log.getSlotsPerSector()) % log.getNbSectors();
+    return sector * TEST_SECTOR_SIZE + FLASH_LOG_SECTOR_HEADER_SIZE
+        + (seq % log.getSlotsPerSector()) * (TEST_PAYLOAD_SIZE + FLASH_LOG_SLOT_HEADER_SIZE);
+}
+
+/**
+ * @brief Records are readable once appended, whether they are still staged or written
+ */
+void test_append_read()
+{
+    RamFlash flash;
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    TEST_ASSERT_EQUAL(TEST_NB_SECTORS, log.getNbSectors());
+    TEST_ASSERT_EQUAL(9, log.getSlotsPerSector());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNextSeq());
+
+    appendRange(log, 0, FLASH_LOG_BATCH + 2);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_LOG_BATCH + 2, log.getNextSeq());
+    for (uint32_t seq = 0; seq < FLASH_LOG_BATCH + 2; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+    TEST_ASSERT_FALSE(log.read(FLASH_LOG_BATCH + 2, flash.m_data.data()));
+
+    // An older record is ignored
+    uint8_t payload[TEST_PAYLOAD_SIZE] = {0};
+    TEST_ASSERT_TRUE(log.append(1, payload));
+    TEST_ASSERT_TRUE(readMatches(log, 1));
+
+    TEST_ASSERT_TRUE(log.flush());
+    for (uint32_t seq = 0; seq < FLASH_LOG_BATCH + 2; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, log.getNbErased());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+}
+
+/**
+ * @brief A new log on the same flash goes on after the last written record
+ */
+void test_remount()
+{
+    RamFlash flash;
+    {
+        FlashLog log(flash, TEST_PAYLOAD_SIZE);
+        TEST_ASSERT_TRUE(log.begin());
+        appendRange(log, 0, 20);
+        TEST_ASSERT_TRUE(log.flush());
+    }
+
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getFirstSeq());
+    TEST_ASSERT_EQUAL_UINT32(20, log.getNextSeq());
+    for (uint32_t seq = 0; seq < 20; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+
+    appendRange(log, 20, 30);
+    TEST_ASSERT_TRUE(log.flush());
+    for (uint32_t seq = 0; seq < 30; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+}
+
+/**
+ * @brief Once the flash is full, the oldest sector is erased and its records are gone
+ */
+void test_wrap_around()
+{
+    RamFlash flash;
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    appendRange(log, 0, 100);
+    TEST_ASSERT_TRUE(log.flush());
+
+    // Sector 100 / 9 = 11 is being filled, so sectors 8 to 11 are on the flash
+    uint32_t firstSeq = 8 * 9;
+    TEST_ASSERT_EQUAL_UINT32(firstSeq, log.getFirstSeq());
+    TEST_ASSERT_FALSE(log.read(firstSeq - 1, flash.m_data.data()));
+    for (uint32_t seq = firstSeq; seq < 100; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, log.getNbErased());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+
+    FlashLog remounted(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(remounted.begin());
+    TEST_ASSERT_EQUAL_UINT32(firstSeq, remounted.getFirstSeq());
+    TEST_ASSERT_EQUAL_UINT32(100, remounted.getNextSeq());
+    TEST_ASSERT_TRUE(readMatches(remounted, 99));
+}
+
+/**
+ * @brief A record that does not match its CRC is reported as missing and counted
+ */
+void test_crc_corruption()
+{
+    RamFlash flash;
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    appendRange(log, 0, 6);
+    TEST_ASSERT_TRUE(log.flush());
+
+    flash.m_data[slotOffset(log, 4) + FLASH_LOG_SLOT_HEADER_SIZE + 10] ^= 0x04;
+    TEST_ASSERT_FALSE(log.read(4, flash.m_data.data() + TEST_SECTOR_SIZE * (TEST_NB_SECTORS - 1)));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getNbCorrupted());
+    TEST_ASSERT_TRUE(readMatches(log, 3));
+    TEST_ASSERT_TRUE(readMatches(log, 5));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getNbCorrupted());
+}
+
+/**
+ * @brief A write cut by a power cut loses the torn record, and the log goes on after it
+ */
+void test_torn_write()
+{
+    RamFlash flash;
+    {
+        FlashLog log(flash, TEST_PAYLOAD_SIZE);
+        TEST_ASSERT_TRUE(log.begin());
+        appendRange(log, 0, 3);
+        flash.m_tearAfter = FLASH_LOG_SLOT_HEADER_SIZE + TEST_PAYLOAD_SIZE + 20;
+        appendRange(log, 3, 5);
+        log.flush();                    // Record 3 is written, record 4 is torn
+    }
+    flash.m_tearAfter = SIZE_MAX;
+
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    TEST_ASSERT_EQUAL_UINT32(5, log.getNextSeq());
+    for (uint32_t seq = 0; seq < 4; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+    TEST_ASSERT_FALSE(readMatches(log, 4));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getNbCorrupted());
+
+    appendRange(log, 5, 8);
+    for (uint32_t seq = 5; seq < 8; seq++) {
+        TEST_ASSERT_TRUE(readMatches(log, seq));
+    }
+}
+
+/**
+ * @brief Sectors written with another record size are ignored, and the log starts after them
+ */
+void test_format_change()
+{
+    RamFlash flash;
+    {
+        FlashLog log(flash, TEST_PAYLOAD_SIZE);
+        TEST_ASSERT_TRUE(log.begin());
+        appendRange(log, 0, 12);
+        TEST_ASSERT_TRUE(log.flush());
+    }
+
+    const uint16_t payloadSize = TEST_PAYLOAD_SIZE + 20;
+    uint8_t payload[payloadSize];
+    uint8_t expected[payloadSize];
+    uint32_t nextSeq;
+    {
+        FlashLog log(flash, payloadSize);
+        TEST_ASSERT_TRUE(log.begin());
+        TEST_ASSERT_EQUAL(7, log.getSlotsPerSector());
+
+        // Sectors 0 and 1 hold the old records: the log opens sector 2
+        nextSeq = log.getNextSeq();
+        TEST_ASSERT_EQUAL_UINT32(2 * 7, nextSeq);
+        for (uint32_t seq = log.getFirstSeq(); seq < nextSeq; seq++) {
+            TEST_ASSERT_FALSE(log.read(seq, payload));
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+
+        fillPayload(nextSeq, payload, payloadSize);
+        TEST_ASSERT_TRUE(log.append(nextSeq, payload));
+        TEST_ASSERT_TRUE(log.flush());
+    }
+
+    FlashLog log(flash, payloadSize);
+    TEST_ASSERT_TRUE(log.begin());
+    TEST_ASSERT_EQUAL_UINT32(nextSeq + 1, log.getNextSeq());
+    fillPayload(nextSeq, expected, payloadSize);
+    TEST_ASSERT_TRUE(log.read(nextSeq, payload));
+    TEST_ASSERT_EQUAL_MEMORY(expected, payload, payloadSize);
+}
+
+/**
+ * @brief Skipped sequence numbers are reported as missing, not as corrupted
+ */
+void test_skipped_seqs()
+{
+    RamFlash flash;
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+    appendRange(log, 0, 2);
+    appendRange(log, 5, 6);             // Same sector
+    appendRange(log, 30, 31);           // Sectors 1 and 2 are never opened
+    TEST_ASSERT_TRUE(log.flush());
+    TEST_ASSERT_EQUAL_UINT32(31, log.getNextSeq());
+
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    for (uint32_t seq = log.getFirstSeq(); seq < log.getNextSeq(); seq++) {
+        bool written = seq < 2 || seq == 5 || seq == 30;
+        TEST_ASSERT_EQUAL(written, readMatches(log, seq));
+    }
+    TEST_ASSERT_FALSE(log.read(2, payload));
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+}
+
+/**
+ * @brief Failed writes and erases are counted and reported by append, and the sector is opened again
+ */
+void test_write_errors()
+{
+    RamFlash flash;
+    FlashLog log(flash, TEST_PAYLOAD_SIZE);
+    TEST_ASSERT_TRUE(log.begin());
+
+    flash.m_fail = true;
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    fillPayload(0, payload);
+    TEST_ASSERT_TRUE(log.append(0, payload));
+    TEST_ASSERT_TRUE(log.append(1, payload));
+    TEST_ASSERT_FALSE(log.append(2, payload));
+    TEST_ASSERT_TRUE(log.getNbWriteErrors() > 0);
+
+    flash.m_fail = false;
+    appendRange(log, 3, 3 + FLASH_LOG_BATCH);
+    TEST_ASSERT_TRUE(readMatches(log, 3));
+    TEST_ASSERT_EQUAL_UINT32(0, log.getNbCorrupted());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_append_read);
+    RUN_TEST(test_remount);
+    RUN_TEST(test_wrap_around);
+    RUN_TEST(test_crc_corruption);
+    RUN_TEST(test_torn_write);
+    RUN_TEST(test_format_change);
+    RUN_TEST(test_skipped_seqs);
+    RUN_TEST(test_write_errors);
+    return UNITY_END();
+}
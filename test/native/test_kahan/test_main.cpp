@@ -0,0 +1,93 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "accumulator.h"
+
+#define NB_UPDATES          (24 * 3600 * 50)        // 24 h of 50 Hz periods
+#define PERIOD_TIME         0.02f                   // s
+#define PERIOD_JITTER       1e-3f                   // Relative
+#define TENSION             230.f                   // V
+#define TENSION_NOISE       2.f                     // V
+
+static std::vector<float> vals;
+static std::vector<float> times;
+
+
+void setUp() {}
+void tearDown() {}
+
+static float uniform()
+{
+    return 2.f * rand() / RAND_MAX - 1.f;
+}
+
+/**
+ * @brief Integrate 24 h of noisy periods with the running mean and with TimeMean, against a double reference
+ */
+void test_kahan_24h()
+{
+    srand(1);
+    vals.resize(NB_UPDATES);
+    times.resize(NB_UPDATES);
+    double refIntegral = 0.;
+    double refDuration = 0.;
+    for (uint32_t n = 0; n < NB_UPDATES; n++) {
+        vals[n] = TENSION + TENSION_NOISE * uniform();
+        times[n] = PERIOD_TIME * (1.f + PERIOD_JITTER * uniform());
+        refIntegral += (double)vals[n] * times[n];
+        refDuration += times[n];
+    }
+    double refMean = refIntegral / refDuration;
+
+    // Running mean, as before TimeMean
+    auto start = std::chrono::steady_clock::now();
+    float runningMean = 0.f;
+    float runningDuration = 0.f;
+    for (uint32_t n = 0; n < NB_UPDATES; n++) {
+        runningMean = (runningMean * runningDuration + vals[n] * times[n]) / (runningDuration + times[n]);
+        runningDuration += times[n];
+    }
+    double runningTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    TimeMean mean;
+    KahanSum duration;
+    mean.init();
+    duration.init();
+    for (uint32_t n = 0; n < NB_UPDATES; n++) {
+        mean.add(vals[n], times[n]);
+        duration.add(times[n]);
+    }
+    double kahanTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double runningError = fabs(runningMean - refMean) / refMean;
+    double runningDurationError = runningDuration - refDuration;
+    double kahanError = fabs(mean.get(duration.get()) - refMean) / refMean;
+    double kahanIntegralError = fabs(mean.integral.get() - refIntegral) / refIntegral;
+    double kahanDurationError = duration.get() - refDuration;
+
+    char message[200];
+    snprintf(message, sizeof(message), "running mean: mean %.2e, duration %+.3f s, %.2f ns/update",
+             runningError, runningDurationError, runningTime * 1e9 / NB_UPDATES);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "TimeMean: mean %.2e, integral %.2e, duration %+.6f s, %.2f ns/update",
+             kahanError, kahanIntegralError, kahanDurationError, kahanTime * 1e9 / NB_UPDATES);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_TRUE(kahanIntegralError < 1e-7);
+    TEST_ASSERT_TRUE(kahanError < 1e-7);
+    TEST_ASSERT_TRUE(fabs(kahanDurationError) < 1e-2);
+    TEST_ASSERT_TRUE(fabs(runningDurationError) > 100 * fabs(kahanDurationError));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_kahan_24h);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "adc.h"
+#include "adcSimulator.h"
+#include "adcDemux.h"
+#include "measure.h"
+#include "harmonics.h"
+#include "jsonWriter.h"
+
+#define SIMULATED_TIME      (MEASURE_PACKET_PERIOD + 10)        // s, one packet and a bit
+#define NB_ENCODES          100000
+#define NB_JSON_WRITES      10000
+
+static uint8_t frame[ADC_FRAME_SIZE];
+static AdcBlock block;
+static std::vector<uint8_t> stream;
+static size_t jsonSize;
+
+
+void setUp() {}
+void tearDown() {}
+
+static bool appendStream(void* ctx, const uint8_t* data, size_t size)
+{
+    stream.insert(stream.end(), data, data + size);
+    return true;
+}
+
+static bool countJson(void* ctx, const char* data, size_t size)
+{
+    jsonSize += size;
+    return true;
+}
+
+/**
+ * @brief Simulate the first packet through the demux, the measure and the harmonic analysis
+ */
+void test_simulate_packet()
+{
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    TEST_ASSERT_TRUE(measure.begin(0));
+
+    uint32_t nbBlocks = (uint32_t)(SIMULATED_TIME * 1000000. / ADC_BLOCK_PERIOD);
+    for (uint32_t b = 0; b < nbBlocks; b++) {
+        demux.parse(frame, simulator.fill(frame, sizeof(frame)), block);
+        measure.adcBlockCallback(block);
+        harmonics.process();
+    }
+    TEST_ASSERT_EQUAL(1, measure.getNbPackets());
+}
+
+/**
+ * @brief The binary stream holds a header describing the layout, then one record per packet
+ */
+void test_binary_stream()
+{
+    stream.clear();
+    TEST_ASSERT_EQUAL(1, measure.writeBinary(0, 10, appendStream, nullptr));
+    TEST_ASSERT_EQUAL(PACKET_HEADER_SIZE + PACKET_RECORD_SIZE, stream.size());
+
+    PacketHeader header;
+    TEST_ASSERT_TRUE(header.decode(stream.data(), stream.size()));
+    TEST_ASSERT_EQUAL(PACKET_HEADER_SIZE, header.headerSize);
+    TEST_ASSERT_EQUAL(PACKET_RECORD_SIZE, header.recordSize);
+    TEST_ASSERT_EQUAL(NB_CURRENTS, header.nbCurrents);
+    TEST_ASSERT_EQUAL(NB_FFT_CHANNELS + 1, header.nbHarmonicChannels);
+    TEST_ASSERT_EQUAL(NB_HARMONICS, header.nbHarmonics);
+    TEST_ASSERT_EQUAL_UINT32(0, header.nbDropped);
+
+    stream[0] ^= 1;
+    TEST_ASSERT_FALSE(header.decode(stream.data(), stream.size()));
+    stream[0] ^= 1;
+    TEST_ASSERT_FALSE(header.decode(stream.data(), PACKET_HEADER_SIZE - 1));
+
+    // Nothing after the last packet
+    stream.clear();
+    TEST_ASSERT_EQUAL(0, measure.writeBinary(measure.getNextSeq(), 10, appendStream, nullptr));
+    TEST_ASSERT_EQUAL(PACKET_HEADER_SIZE, stream.size());
+}
+
+/**
+ * @brief A decoded record holds the values of the packet, and encodes to the same bytes again
+ */
+void test_record_round_trip()
+{
+    Measure::Data data;
+    Measure::Data decoded;
+    TEST_ASSERT_TRUE(measure.getPacket(0, data));
+
+    stream.clear();
+    measure.writeBinary(0, 1, appendStream, nullptr);
+    const uint8_t* record = stream.data() + PACKET_HEADER_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(0, Measure::decodeRecord(record, decoded));
+
+    TEST_ASSERT_TRUE(decoded.timestamp == data.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(data.duration, decoded.duration);
+    TEST_ASSERT_EQUAL_FLOAT(data.tension.rms.mean, decoded.tension.rms.mean);
+    TEST_ASSERT_EQUAL_FLOAT(data.tension.freq.max, decoded.tension.freq.max);
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(data.currents[i].rms.min, decoded.currents[i].rms.min);
+        TEST_ASSERT_EQUAL_FLOAT(data.currents[i].activePower.mean, decoded.currents[i].activePower.mean);
+        TEST_ASSERT_EQUAL_FLOAT(data.currents[i].powerFactor.max, decoded.currents[i].powerFactor.max);
+        TEST_ASSERT_EQUAL_FLOAT(data.currents[i].energy, decoded.currents[i].energy);
+        TEST_ASSERT_TRUE(decoded.energy.importEnergy[i] == data.energy.importEnergy[i]);
+        TEST_ASSERT_TRUE(decoded.energy.exportEnergy[i] == data.energy.exportEnergy[i]);
+    }
+    for (uint8_t h = 0; h < NB_FFT_CHANNELS + 1; h++) {
+        TEST_ASSERT_EQUAL_FLOAT(data.harmonics[h].thd.mean, decoded.harmonics[h].thd.mean);
+        TEST_ASSERT_EQUAL_MEMORY(data.harmonics[h].harmonics, decoded.harmonics[h].harmonics,
+                                 sizeof(data.harmonics[h].harmonics));
+    }
+
+    uint8_t encoded[PACKET_RECORD_SIZE];
+    Measure::encodeRecord(encoded, 0, decoded);
+    TEST_ASSERT_EQUAL_MEMORY(record, encoded, PACKET_RECORD_SIZE);
+}
+
+/**
+ * @brief Compare the size and the time of a record with the JSON of the same packet
+ */
+void test_record_vs_json()
+{
+    Measure::Data data;
+    TEST_ASSERT_TRUE(measure.getPacket(0, data));
+
+    static uint8_t encoded[PACKET_RECORD_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < NB_ENCODES; n++) {
+        Measure::encodeRecord(encoded, n, data);
+        asm volatile("" : : "r"(encoded) : "memory");
+    }
+    double recordTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / NB_ENCODES;
+
+    jsonSize = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < NB_JSON_WRITES; n++) {
+        JsonWriter writer(countJson, nullptr);
+        writer.beginObject();
+        writer.addNumber("seq", n);
+        Measure::writeJsonFields(writer, data);
+        writer.endObject();
+        writer.flush();
+    }
+    double jsonTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / NB_JSON_WRITES;
+    jsonSize /= NB_JSON_WRITES;
+
+    char message[160];
+    snprintf(message, sizeof(message), "record %u bytes in %.2f us, JSON %zu bytes in %.1f us",
+             PACKET_RECORD_SIZE, recordTime * 1e6, jsonSize, jsonTime * 1e6);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(PACKET_RECORD_SIZE < jsonSize);
+    TEST_ASSERT_TRUE(recordTime < jsonTime);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_simulate_packet);
+    RUN_TEST(test_binary_stream);
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_record_vs_json);
+    return UNITY_END();
+}
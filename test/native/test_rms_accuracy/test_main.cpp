@@ -0,0 +1,189 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#include "adc.h"
+#include "adcSimulator.h"
+#include "adcDemux.h"
+#include "measure.h"
+#include "signals.h"
+
+// RMS of the simulated waveform relative to its fundamental: 5% of H3 and 3% of H5 (see adcSimulator.cpp)
+#define SIM_HARMONIC_FACTOR     sqrtf(1.f + 0.05f * 0.05f + 0.03f * 0.03f)
+
+#define REFERENCE_TIME          60          // s of simulated frames compared with the reference
+
+static uint8_t frame[ADC_FRAME_SIZE];
+static AdcBlock block;
+
+
+// Previous RMS accumulation, kept as a reference: double-precision pow per sample and per period
+struct DoubleRms
+{
+    float m_temp = 0.f;
+    float m_last = 0.f;
+
+    void update(float val, float deltaT) {m_temp += pow(val, 2) * deltaT;}
+    void save(float periodTime)
+    {
+        m_last = pow(m_temp / periodTime, 0.5);
+        m_temp = 0.;
+    }
+};
+
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * @brief RMS of a sine sampled at TIM_PERIOD, one mains period at a time, as Measure feeds Rms
+ */
+void test_rms_of_a_sampled_sine()
+{
+    const float amplitude = 325.f;
+    const float dt = TIM_PERIOD / 1000000.f;
+    const float periodTime = (float)NB_SAMPLES * dt;
+    const uint32_t nbPeriods = MEASURE_PACKET_PERIOD / periodTime;
+    Rms rms;
+
+    for (uint32_t p = 0; p < nbPeriods; p++) {
+        for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+            rms.update(amplitude * sinf(2.f * (float)M_PI * n / NB_SAMPLES), dt);
+        }
+        rms.save(periodTime);
+    }
+
+    float expected = amplitude / sqrtf(2.f);
+    RangeData data = rms.getData(nbPeriods * periodTime);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-5f, expected, rms.getLast());
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-5f, expected, data.min);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-5f, expected, data.max);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 1e-5f, expected, data.mean);
+}
+
+/**
+ * @brief RMS values of a packet of simulated frames against the amplitudes of the simulator
+ *
+ * The bound covers the truncation of the samples to whole ADC counts and the
+ * interpolation of the zero crossings.
+ */
+void test_rms_of_the_simulated_channels()
+{
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    TEST_ASSERT_TRUE(measure.begin(0));
+
+    uint32_t nbBlocks = (uint32_t)((MEASURE_PACKET_PERIOD + 10) * 1000000. / ADC_BLOCK_PERIOD);
+    for (uint32_t b = 0; b < nbBlocks; b++) {
+        demux.parse(frame, simulator.fill(frame, sizeof(frame)), block);
+        measure.adcBlockCallback(block);
+    }
+
+    Measure::Data data;
+    TEST_ASSERT_TRUE(measure.getPacket(measure.getFirstSeq(), data));
+
+    char message[120];
+    float expected = SIM_TENSION_AMPLITUDE * ActiveLayout::calibA[TENSION_ID] / sqrtf(2.f) * SIM_HARMONIC_FACTOR;
+    snprintf(message, sizeof(message), "tension: %.3f V, expected %.3f V", data.tension.rms.mean, expected);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(expected * 5e-4f, expected, data.tension.rms.mean);
+
+    for (uint8_t i = 0; i < NB_CURRENTS; i++) {
+        expected = SIM_CURRENT_AMPLITUDE / (i + 1) * ActiveLayout::calibA[i] / sqrtf(2.f) * SIM_HARMONIC_FACTOR;
+        snprintf(message, sizeof(message), "current %u: %.4f A, expected %.4f A", i, data.currents[i].rms.mean, expected);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_FLOAT_WITHIN(expected * 5e-4f, expected, data.currents[i].rms.mean);
+    }
+}
+
+/**
+ * @brief Single-precision MAC and sqrtf against the previous double-precision pow, on the simulated channels
+ *
+ * The values of every channel are computed beforehand, so that only the accumulation is timed.
+ */
+void test_rms_against_double_reference()
+{
+    AdcSimulator simulator(ActiveLayout::adcChannels);
+    AdcDemux demux(ActiveLayout::adcChannels);
+    const float dt = TIM_PERIOD / 1000000.f;
+    const float periodTime = (float)NB_SAMPLES * dt;
+
+    // Calibrated values of the currents and the tension, a whole number of periods
+    std::vector<float> vals[NB_CURRENTS + 1];
+    uint32_t nbBlocks = (uint32_t)(REFERENCE_TIME * 1000000. / ADC_BLOCK_PERIOD);
+    for (uint32_t b = 0; b < nbBlocks; b++) {
+        demux.parse(frame, simulator.fill(frame, sizeof(frame)), block);
+        for (uint16_t n = 0; n < block.nbSamples; n++) {
+            for (uint8_t c = 0; c <= NB_CURRENTS; c++) {
+                int32_t raw = (int32_t)block.samples[c][n] - block.samples[VREF_ID][n];
+                vals[c].push_back(ActiveLayout::calibA[c] * raw + ActiveLayout::calibB[c]);
+            }
+        }
+    }
+    const uint32_t nbPeriods = vals[0].size() / NB_SAMPLES;
+
+    float worstError = 0.f;
+    for (uint8_t c = 0; c <= NB_CURRENTS; c++) {
+        Rms rms;
+        DoubleRms reference;
+        for (uint32_t p = 0; p < nbPeriods; p++) {
+            for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+                rms.update(vals[c][p * NB_SAMPLES + n], dt);
+                reference.update(vals[c][p * NB_SAMPLES + n], dt);
+            }
+            rms.save(periodTime);
+            reference.save(periodTime);
+            float error = fabsf(rms.getLast() - reference.m_last) / reference.m_last;
+            if (error > worstError) {
+                worstError = error;
+            }
+        }
+    }
+
+    volatile float sink = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (uint8_t c = 0; c <= NB_CURRENTS; c++) {
+        Rms rms;
+        for (uint32_t p = 0; p < nbPeriods; p++) {
+            for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+                rms.update(vals[c][p * NB_SAMPLES + n], dt);
+            }
+            rms.save(periodTime);
+        }
+        sink = sink + rms.getLast();
+    }
+    double floatTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint8_t c = 0; c <= NB_CURRENTS; c++) {
+        DoubleRms reference;
+        for (uint32_t p = 0; p < nbPeriods; p++) {
+            for (uint16_t n = 0; n < NB_SAMPLES; n++) {
+                reference.update(vals[c][p * NB_SAMPLES + n], dt);
+            }
+            reference.save(periodTime);
+        }
+        sink = sink + reference.m_last;
+    }
+    double doubleTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double nbSamples = (double)nbPeriods * NB_SAMPLES * (NB_CURRENTS + 1);
+    char message[200];
+    snprintf(message, sizeof(message), "worst relative error %.2e over %lu periods, %.2f ns/sample (float) vs %.2f ns/sample (double): %.2f ns saved",
+             worstError, (unsigned long)nbPeriods, floatTime * 1e9 / nbSamples, doubleTime * 1e9 / nbSamples,
+             (doubleTime - floatTime) * 1e9 / nbSamples);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worstError < 1e-5f);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rms_of_a_sampled_sine);
+    RUN_TEST(test_rms_of_the_simulated_channels);
+    RUN_TEST(test_rms_against_double_reference);
+    return UNITY_END();
+}
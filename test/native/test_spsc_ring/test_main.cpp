@@ -0,0 +1,99 @@
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "spscRing.h"
+
+#define STRESS_NB_ITEMS     2000000
+#define ITEM_SIZE           16
+
+// Every word of an item is derived from its sequence number, so a torn item is detected
+struct Item {
+    uint32_t seq;
+    uint32_t words[ITEM_SIZE];
+};
+
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_and_empty()
+{
+    SpscRing<uint32_t, 4> ring;
+    uint32_t val;
+
+    TEST_ASSERT_FALSE(ring.pop(val));
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_FALSE(ring.push(4));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getNbOverrun());
+    TEST_ASSERT_EQUAL(4, ring.getHighWater());
+
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.pop(val));
+        TEST_ASSERT_EQUAL_UINT32(i, val);
+    }
+    TEST_ASSERT_FALSE(ring.pop(val));
+    TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+/**
+ * @brief One producer and one consumer thread, the producer filling the slots in place
+ *
+ * The consumer checks that the items come in order, none is lost and none is torn.
+ */
+void test_producer_consumer_stress()
+{
+    static SpscRing<Item, 8> ring;
+    std::atomic<bool> failed(false);
+
+    std::thread consumer([&failed]() {
+        uint32_t expected = 0;
+        while (expected < STRESS_NB_ITEMS && !failed) {
+            Item* item = ring.front();
+            if (item == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+            bool ok = (item->seq == expected);
+            for (uint8_t i = 0; i < ITEM_SIZE; i++) {
+                ok = ok && (item->words[i] == item->seq * 31 + i);
+            }
+            ring.release();
+            if (!ok) {
+                failed = true;
+            }
+            expected++;
+        }
+    });
+
+    for (uint32_t seq = 0; seq < STRESS_NB_ITEMS && !failed; ) {
+        Item* item = ring.reserve();
+        if (item == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        item->seq = seq;
+        for (uint8_t i = 0; i < ITEM_SIZE; i++) {
+            item->words[i] = seq * 31 + i;
+        }
+        ring.commit();
+        seq++;
+    }
+    consumer.join();
+
+    TEST_ASSERT_FALSE(failed);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_NB_ITEMS, ring.getNbPushed());
+    TEST_ASSERT_EQUAL(0, ring.size());
+    TEST_ASSERT_TRUE(ring.getHighWater() <= ring.capacity());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_full_and_empty);
+    RUN_TEST(test_producer_consumer_stress);
+    return UNITY_END();
+}